@@ -0,0 +1,691 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "analysis.h"
+#include "reach.h"
+#include "node.h"
+
+namespace
+{
+
+typedef uint64_t word;
+
+// Rows of the bitsets are whole SSE2 vectors of two words.
+const size_t vector_words = 2;
+
+// How many terminals a conflict lists.
+const size_t max_names = 6;
+
+////////////////////////////////////////
+
+// dst |= src, returning whether dst changed.
+inline bool or_into( word *dst, const word *src, size_t n )
+{
+#ifdef __SSE2__
+	__m128i added = _mm_setzero_si128();
+	for ( size_t i = 0; i < n; i += vector_words )
+	{
+		__m128i d = _mm_loadu_si128( reinterpret_cast<const __m128i *>( dst + i ) );
+		__m128i s = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src + i ) );
+		added = _mm_or_si128( added, _mm_andnot_si128( d, s ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i *>( dst + i ), _mm_or_si128( d, s ) );
+	}
+	return _mm_movemask_epi8( _mm_cmpeq_epi8( added, _mm_setzero_si128() ) ) != 0xFFFF;
+#else
+	word added = 0;
+	for ( size_t i = 0; i < n; ++i )
+	{
+		added |= src[i] & ~dst[i];
+		dst[i] |= src[i];
+	}
+	return added != 0;
+#endif
+}
+
+////////////////////////////////////////
+
+inline bool intersects( const word *a, const word *b, size_t n )
+{
+#ifdef __SSE2__
+	__m128i both = _mm_setzero_si128();
+	for ( size_t i = 0; i < n; i += vector_words )
+	{
+		__m128i x = _mm_loadu_si128( reinterpret_cast<const __m128i *>( a + i ) );
+		__m128i y = _mm_loadu_si128( reinterpret_cast<const __m128i *>( b + i ) );
+		both = _mm_or_si128( both, _mm_and_si128( x, y ) );
+	}
+	return _mm_movemask_epi8( _mm_cmpeq_epi8( both, _mm_setzero_si128() ) ) != 0xFFFF;
+#else
+	word both = 0;
+	for ( size_t i = 0; i < n; ++i )
+		both |= a[i] & b[i];
+	return both != 0;
+#endif
+}
+
+////////////////////////////////////////
+
+inline void set_bit( word *set, int bit )
+{
+	set[size_t( bit ) / 64] |= word( 1 ) << ( size_t( bit ) % 64 );
+}
+
+////////////////////////////////////////
+
+// The names, each after a space.
+string join( const vector<string> &names )
+{
+	string result;
+	for ( size_t i = 0; i < names.size(); ++i )
+	{
+		result.push_back( ' ' );
+		result += names[i];
+	}
+	return result;
+}
+
+}
+
+////////////////////////////////////////
+
+grammar_analysis::grammar_analysis( const node *gram )
+	: _prods( grammar_productions( gram ) ), _depth( 0 ), _words( 0 )
+{
+	_terms.intern( "$" );
+	for ( size_t i = 0; i < _prods.size(); ++i )
+	{
+		const literal *id = dynamic_cast<const literal*>( _prods[i]->id() );
+		_defines.push_back( _nonterms.intern( id ? id->value() : string() ) );
+	}
+	for ( size_t i = 0; i < _prods.size(); ++i )
+		_roots.push_back( compile( _prods[i]->expr(), 0 ) );
+
+	size_t nts = _nonterms.size();
+	_words = ( _terms.size() + 64 * vector_words - 1 ) / ( 64 * vector_words ) * vector_words;
+	_nullable.assign( nts, 0 );
+	_first.assign( nts * _words, 0 );
+	_follow.assign( nts * _words, 0 );
+	_scratch.assign( size_t( _depth + 2 ) * 2 * _words, 0 );
+
+	vector<vector<size_t>> defs( nts );
+	for ( size_t p = 0; p < _prods.size(); ++p )
+		defs[size_t( _defines[p] )].push_back( p );
+
+	// Nullable goes first, since it decides which nonterminals the FIRST
+	// of a production depends on.
+	for ( bool changed = true; changed; )
+	{
+		changed = false;
+		for ( size_t p = 0; p < _prods.size(); ++p )
+		{
+			char &n = _nullable[size_t( _defines[p] )];
+			if ( !n && first_of( _roots[p], NULL ) )
+				n = changed = true;
+		}
+	}
+
+	// The nonterminals a production can start with.  Components come
+	// after the ones they lead to, so their FIRST sets are done by then,
+	// and only the cyclic ones (left recursion) need iterating.
+	vector<int> all( nts );
+	for ( size_t i = 0; i < nts; ++i )
+		all[i] = int( i );
+	graph_components comps = strong_components( nts, all, [&]( int v, vector<int> &out )
+	{
+		for ( size_t p: defs[size_t( v )] )
+			left_of( _roots[p], out );
+	} );
+
+	word *tmp = &_scratch[0];
+	for ( size_t c = 0; c < comps.list.size(); ++c )
+	{
+		bool changed = true;
+		while ( changed )
+		{
+			changed = false;
+			for ( int nt: comps.list[c] )
+			{
+				for ( size_t p: defs[size_t( nt )] )
+				{
+					fill( tmp, tmp + _words, 0 );
+					first_of( _roots[p], tmp );
+					if ( or_into( row( _first, size_t( nt ) ), tmp, _words ) )
+						changed = true;
+				}
+			}
+			if ( !comps.cyclic[c] )
+				break;
+		}
+
+		if ( comps.cyclic[c] )
+		{
+			vector<size_t> group;
+			for ( int nt: comps.list[c] )
+				group.insert( group.end(), defs[size_t( nt )].begin(), defs[size_t( nt )].end() );
+			sort( group.begin(), group.end() );
+			_left.push_back( group );
+		}
+	}
+	sort( _left.begin(), _left.end() );
+
+	item_firsts();
+
+	// FOLLOW flows from where a nonterminal is used to its productions,
+	// which top down grammars mostly list later.
+	if ( !_prods.empty() )
+		set_bit( row( _follow, size_t( _defines[0] ) ), 0 );
+	for ( bool changed = true; changed; )
+	{
+		changed = false;
+		for ( size_t p = 0; p < _prods.size(); ++p )
+		{
+			if ( follow_walk( _roots[p], row( _follow, size_t( _defines[p] ) ), 0, false, p ) )
+				changed = true;
+		}
+	}
+
+	for ( size_t p = 0; p < _prods.size(); ++p )
+		follow_walk( _roots[p], row( _follow, size_t( _defines[p] ) ), 0, true, p );
+}
+
+////////////////////////////////////////
+
+const string &grammar_analysis::prod_name( size_t prod ) const
+{
+	return _nonterms.name( _defines.at( prod ) );
+}
+
+////////////////////////////////////////
+
+bool grammar_analysis::nullable( size_t prod ) const
+{
+	return _nullable[size_t( _defines.at( prod ) )] != 0;
+}
+
+////////////////////////////////////////
+
+vector<string> grammar_analysis::first( size_t prod ) const
+{
+	return names( row( _first, size_t( _defines.at( prod ) ) ) );
+}
+
+////////////////////////////////////////
+
+vector<string> grammar_analysis::follow( size_t prod ) const
+{
+	return names( row( _follow, size_t( _defines.at( prod ) ) ) );
+}
+
+////////////////////////////////////////
+
+void grammar_analysis::report( ostream &out ) const
+{
+	for ( const conflict &c: _conflicts )
+		out << "LL(1) conflict in " << prod_name( c.prod ) << ": " << c.what << '\n';
+
+	for ( const vector<size_t> &group: _left )
+	{
+		out << "Left recursion:";
+		for ( size_t p: group )
+			out << ' ' << prod_name( p );
+		out << '\n';
+	}
+}
+
+////////////////////////////////////////
+
+void grammar_analysis::notes( unordered_map<string,string> &out ) const
+{
+	vector<char> left( _nonterms.size(), 0 );
+	for ( const vector<size_t> &group: _left )
+	{
+		for ( size_t p: group )
+			left[size_t( _defines[p] )] = 1;
+	}
+
+	for ( size_t p = 0; p < _prods.size(); ++p )
+	{
+		string &note = out[prod_name( p )];
+		if ( !note.empty() )
+			continue;
+		if ( nullable( p ) )
+			note += "nullable\n";
+		note += "FIRST:" + join( first( p ) ) + '\n';
+		note += "FOLLOW:" + join( follow( p ) );
+		if ( left[size_t( _defines[p] )] )
+			note += "\nleft recursive";
+	}
+
+	for ( const conflict &c: _conflicts )
+		out[prod_name( c.prod )] += "\nLL(1) conflict: " + c.what;
+}
+
+////////////////////////////////////////
+
+int grammar_analysis::compile( const node *n, int depth )
+{
+	_depth = max( _depth, depth );
+
+	// The children go on a stack shared by all levels, and are moved to
+	// _kids together once they are all done.
+	item it = { SEQ, -1, 0, 0 };
+	size_t base = _stack.size();
+	if ( const literal *lit = dynamic_cast<const literal*>( n ) )
+	{
+		int nt = lit->quote() == '\0' ? _nonterms.find( lit->value() ) : -1;
+		if ( nt >= 0 )
+		{
+			it.kind = NONTERM;
+			it.sym = nt;
+		}
+		else
+		{
+			it.kind = TERMINAL;
+			it.sym = _terms.intern( lit->quote() == '\0' ? lit->value() : '"' + lit->value() + '"' );
+		}
+	}
+	else if ( const expression *e = dynamic_cast<const expression*>( n ) )
+	{
+		it.kind = ALT;
+		for ( size_t i = 0; i < e->size(); ++i )
+			_stack.push_back( compile( e->at( int( i ) ), depth + 1 ) );
+	}
+	else if ( const term *t = dynamic_cast<const term*>( n ) )
+	{
+		it.kind = SEQ;
+		for ( size_t i = 0; i < t->size(); ++i )
+			_stack.push_back( compile( t->at( int( i ) ), depth + 1 ) );
+	}
+	else if ( const optional *o = dynamic_cast<const optional*>( n ) )
+	{
+		it.kind = OPT;
+		_stack.push_back( compile( o->expr(), depth + 1 ) );
+	}
+	else if ( const repetition *r = dynamic_cast<const repetition*>( n ) )
+	{
+		it.kind = REP;
+		_stack.push_back( compile( r->expr(), depth + 1 ) );
+	}
+	else if ( const onemore *m = dynamic_cast<const onemore*>( n ) )
+	{
+		it.kind = MORE;
+		_stack.push_back( compile( m->expr(), depth + 1 ) );
+		if ( m->sep() )
+			_stack.push_back( compile( m->sep(), depth + 1 ) );
+	}
+	else
+		throw runtime_error( "Unknown node in grammar" );
+
+	// Children come before their parent, so item_firsts() can go in order.
+	it.first = int( _kids.size() );
+	it.count = int( _stack.size() - base );
+	_kids.insert( _kids.end(), _stack.begin() + ptrdiff_t( base ), _stack.end() );
+	_stack.resize( base );
+	_items.push_back( it );
+	return int( _items.size() ) - 1;
+}
+
+////////////////////////////////////////
+
+// Adds the FIRST set of item i to out (unless out is NULL), using the
+// FIRST sets of the nonterminals found so far, and returns whether it
+// is nullable.
+bool grammar_analysis::first_of( int i, word *out ) const
+{
+	const item &it = _items[size_t( i )];
+	const int *kids = _kids.data() + it.first;
+	switch ( it.kind )
+	{
+		case TERMINAL:
+			if ( out )
+				set_bit( out, it.sym );
+			return false;
+
+		case NONTERM:
+			if ( out )
+				or_into( out, row( _first, size_t( it.sym ) ), _words );
+			return _nullable[size_t( it.sym )] != 0;
+
+		case SEQ:
+			for ( int k = 0; k < it.count; ++k )
+			{
+				if ( !first_of( kids[k], out ) )
+					return false;
+			}
+			return true;
+
+		case ALT:
+		{
+			bool n = false;
+			for ( int k = 0; k < it.count; ++k )
+			{
+				if ( first_of( kids[k], out ) )
+					n = true;
+			}
+			return n;
+		}
+
+		case OPT:
+		case REP:
+			first_of( kids[0], out );
+			return true;
+
+		case MORE:
+			if ( !first_of( kids[0], out ) )
+				return false;
+			if ( it.count > 1 )
+				first_of( kids[1], out );
+			return true;
+	}
+	return false;
+}
+
+////////////////////////////////////////
+
+// The same as first_of() for every item at once, once the nonterminals
+// are done.
+void grammar_analysis::item_firsts( void )
+{
+	_item_nullable.assign( _items.size(), 0 );
+	_item_first.assign( _items.size() * _words, 0 );
+	for ( size_t i = 0; i < _items.size(); ++i )
+	{
+		const item &it = _items[i];
+		const int *kids = _kids.data() + it.first;
+		word *out = row( _item_first, i );
+		char n = 0;
+		switch ( it.kind )
+		{
+			case TERMINAL:
+				set_bit( out, it.sym );
+				break;
+
+			case NONTERM:
+				or_into( out, row( _first, size_t( it.sym ) ), _words );
+				n = _nullable[size_t( it.sym )];
+				break;
+
+			case SEQ:
+				n = 1;
+				for ( int k = 0; k < it.count && n; ++k )
+				{
+					or_into( out, row( _item_first, size_t( kids[k] ) ), _words );
+					n = _item_nullable[size_t( kids[k] )];
+				}
+				break;
+
+			case ALT:
+				for ( int k = 0; k < it.count; ++k )
+				{
+					or_into( out, row( _item_first, size_t( kids[k] ) ), _words );
+					n |= _item_nullable[size_t( kids[k] )];
+				}
+				break;
+
+			case OPT:
+			case REP:
+				or_into( out, row( _item_first, size_t( kids[0] ) ), _words );
+				n = 1;
+				break;
+
+			case MORE:
+				or_into( out, row( _item_first, size_t( kids[0] ) ), _words );
+				n = _item_nullable[size_t( kids[0] )];
+				if ( n && it.count > 1 )
+					or_into( out, row( _item_first, size_t( kids[1] ) ), _words );
+				break;
+		}
+		_item_nullable[i] = n;
+	}
+}
+
+////////////////////////////////////////
+
+// Adds what may follow each nonterminal in item i to its FOLLOW set,
+// given the trailer that may follow the item, and returns whether any
+// changed.  With check, records the conflicts instead.  Each level of
+// the tree has two rows of scratch space.
+bool grammar_analysis::follow_walk( int i, const word *trailer, int depth, bool check, size_t prod )
+{
+	const item it = _items[size_t( i )];
+	const int *kids = _kids.data() + it.first;
+	word *t0 = &_scratch[size_t( depth + 1 ) * 2 * _words];
+	word *t1 = t0 + _words;
+	bool changed = false;
+
+	switch ( it.kind )
+	{
+		case TERMINAL:
+			break;
+
+		case NONTERM:
+			if ( !check )
+				changed = or_into( row( _follow, size_t( it.sym ) ), trailer, _words );
+			break;
+
+		case SEQ:
+			copy( trailer, trailer + _words, t0 );
+			for ( int k = it.count - 1; k >= 0; --k )
+			{
+				size_t kid = size_t( kids[k] );
+				if ( follow_walk( kids[k], t0, depth + 1, check, prod ) )
+					changed = true;
+				if ( !_item_nullable[kid] )
+					fill( t0, t0 + _words, 0 );
+				or_into( t0, row( _item_first, kid ), _words );
+			}
+			break;
+
+		case ALT:
+		{
+			int empty = -1;
+			for ( int k = 0; k < it.count; ++k )
+			{
+				if ( follow_walk( kids[k], trailer, depth + 1, check, prod ) )
+					changed = true;
+				if ( !check )
+					continue;
+
+				const word *fk = row( _item_first, size_t( kids[k] ) );
+				for ( int j = 0; j < k; ++j )
+				{
+					const word *fj = row( _item_first, size_t( kids[j] ) );
+					if ( intersects( fj, fk, _words ) )
+						add_conflict( prod, "alternatives " + to_string( j + 1 ) + " and " + to_string( k + 1 ) + " both start with", fj, fk );
+				}
+				if ( _item_nullable[size_t( kids[k] )] )
+				{
+					if ( empty >= 0 )
+						add_conflict( prod, "alternatives " + to_string( empty + 1 ) + " and " + to_string( k + 1 ) + " can both be empty" );
+					else
+						empty = k;
+				}
+			}
+
+			if ( check && empty >= 0 )
+			{
+				for ( int k = 0; k < it.count; ++k )
+				{
+					const word *fk = row( _item_first, size_t( kids[k] ) );
+					if ( k != empty && intersects( fk, trailer, _words ) )
+						add_conflict( prod, "alternative " + to_string( empty + 1 ) + " can be empty, and alternative " + to_string( k + 1 ) + " starts with what may follow", fk, trailer );
+				}
+			}
+			break;
+		}
+
+		case OPT:
+		{
+			changed = follow_walk( kids[0], trailer, depth + 1, check, prod );
+			if ( check )
+			{
+				const word *f = row( _item_first, size_t( kids[0] ) );
+				if ( intersects( f, trailer, _words ) )
+					add_conflict( prod, "[ ] starts with what may follow it", f, trailer );
+				if ( _item_nullable[size_t( kids[0] )] )
+					add_conflict( prod, "the inside of [ ] can be empty" );
+			}
+			break;
+		}
+
+		case REP:
+		case MORE:
+		{
+			// Once around, x may be followed by another x, or by the
+			// separator s and then x.
+			const word *fx = row( _item_first, size_t( kids[0] ) );
+			bool nx = _item_nullable[size_t( kids[0] )] != 0;
+			bool ns = true;
+			copy( trailer, trailer + _words, t0 );
+			if ( it.count > 1 )
+			{
+				const word *fs = row( _item_first, size_t( kids[1] ) );
+				ns = _item_nullable[size_t( kids[1] )] != 0;
+				or_into( t0, fs, _words );
+				if ( ns )
+					or_into( t0, fx, _words );
+
+				copy( fx, fx + _words, t1 );
+				if ( nx )
+					or_into( t1, t0, _words );
+				if ( follow_walk( kids[1], t1, depth + 1, check, prod ) )
+					changed = true;
+
+				// What goes around again.
+				copy( fs, fs + _words, t1 );
+				if ( ns )
+					or_into( t1, fx, _words );
+			}
+			else
+			{
+				or_into( t0, fx, _words );
+				copy( fx, fx + _words, t1 );
+			}
+			if ( follow_walk( kids[0], t0, depth + 1, check, prod ) )
+				changed = true;
+
+			if ( check )
+			{
+				const char *brackets = it.kind == REP ? "{ }" : "< >";
+				if ( intersects( t1, trailer, _words ) )
+					add_conflict( prod, string( brackets ) + " goes around again on what may follow it", t1, trailer );
+				if ( nx && ns )
+					add_conflict( prod, "the inside of " + string( brackets ) + " can be empty" );
+			}
+			break;
+		}
+	}
+	return changed;
+}
+
+////////////////////////////////////////
+
+// Adds the nonterminals that item i can start with to out, and returns
+// whether it is nullable.
+bool grammar_analysis::left_of( int i, vector<int> &out ) const
+{
+	const item &it = _items[size_t( i )];
+	const int *kids = _kids.data() + it.first;
+	switch ( it.kind )
+	{
+		case TERMINAL:
+			return false;
+
+		case NONTERM:
+			out.push_back( it.sym );
+			return _nullable[size_t( it.sym )] != 0;
+
+		case SEQ:
+			for ( int k = 0; k < it.count; ++k )
+			{
+				if ( !left_of( kids[k], out ) )
+					return false;
+			}
+			return true;
+
+		case ALT:
+		{
+			bool n = false;
+			for ( int k = 0; k < it.count; ++k )
+			{
+				if ( left_of( kids[k], out ) )
+					n = true;
+			}
+			return n;
+		}
+
+		case OPT:
+		case REP:
+			left_of( kids[0], out );
+			return true;
+
+		case MORE:
+			if ( !left_of( kids[0], out ) )
+				return false;
+			if ( it.count > 1 )
+				left_of( kids[1], out );
+			return true;
+	}
+	return false;
+}
+
+////////////////////////////////////////
+
+// Records a conflict, listing the terminals in both a and b.
+void grammar_analysis::add_conflict( size_t prod, const string &what, const word *a, const word *b )
+{
+	conflict c = { prod, what };
+	if ( a && b )
+	{
+		vector<word> both( _words );
+		for ( size_t i = 0; i < _words; ++i )
+			both[i] = a[i] & b[i];
+		vector<string> list = names( both.data() );
+		if ( list.size() > max_names )
+		{
+			list.resize( max_names );
+			list.push_back( "..." );
+		}
+		c.what += ":" + join( list );
+	}
+	_conflicts.push_back( c );
+}
+
+////////////////////////////////////////
+
+vector<string> grammar_analysis::names( const word *set ) const
+{
+	vector<string> result;
+	for ( size_t i = 0; i < _words; ++i )
+	{
+		for ( word w = set[i]; w; w &= w - 1 )
+			result.push_back( _terms.name( int( i * 64 + size_t( __builtin_ctzll( w ) ) ) ) );
+	}
+	return result;
+}
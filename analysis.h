@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xref.h"
+
+class node;
+
+using namespace std;
+
+////////////////////////////////////////
+
+// Nullable, FIRST and FOLLOW sets of a grammar, and what keeps it from
+// being LL(1).  Terminals are the quoted literals, and the nonterminals
+// that no production defines (usually tokens of the lexer); the end of
+// the input is the terminal "$", which follows the first production.
+//
+// The tree is first compiled into a flat array of items.  Sets are rows
+// of a dense bitset indexed by terminal, padded to whole SSE2 vectors,
+// and all set operations go a vector at a time.  FIRST is found one
+// strongly connected component of productions at a time, in dependency
+// order, so only recursive productions are iterated to a fixpoint;
+// FOLLOW is iterated over the whole grammar.
+class grammar_analysis
+{
+public:
+	grammar_analysis( const node *gram );
+
+	struct conflict
+	{
+		// The production it is in, and what the conflict is.
+		size_t prod;
+		string what;
+	};
+
+	inline size_t prod_count( void ) const { return _prods.size(); }
+	inline size_t terminal_count( void ) const { return _terms.size(); }
+	const string &prod_name( size_t prod ) const;
+
+	bool nullable( size_t prod ) const;
+	vector<string> first( size_t prod ) const;
+	vector<string> follow( size_t prod ) const;
+
+	inline const vector<conflict> &conflicts( void ) const { return _conflicts; }
+
+	// Groups of productions that derive themselves at their start.
+	inline const vector<vector<size_t>> &left_recursion( void ) const { return _left; }
+
+	// Prints the conflicts and the left recursive groups, one per line.
+	void report( ostream &out ) const;
+
+	// A note on every production: nullable, FIRST, FOLLOW and its
+	// conflicts, one per line.
+	void notes( unordered_map<string,string> &out ) const;
+
+private:
+	typedef uint64_t word;
+
+	enum Item
+	{
+		TERMINAL,
+		NONTERM,
+		SEQ,
+		ALT,
+		OPT,
+		REP,
+		MORE
+	};
+
+	// A node of the tree: terminals and nonterminals have their symbol,
+	// the others their children in _kids[first, first+count).
+	struct item
+	{
+		Item kind;
+		int sym;
+		int first;
+		int count;
+	};
+
+	int compile( const node *n, int depth );
+
+	inline word *row( vector<word> &sets, size_t i ) { return &sets[i * _words]; }
+	inline const word *row( const vector<word> &sets, size_t i ) const { return &sets[i * _words]; }
+
+	bool first_of( int i, word *out ) const;
+	void item_firsts( void );
+	bool follow_walk( int i, const word *trailer, int depth, bool check, size_t prod );
+	bool left_of( int i, vector<int> &out ) const;
+
+	void add_conflict( size_t prod, const string &what, const word *a = NULL, const word *b = NULL );
+	vector<string> names( const word *set ) const;
+
+	vector<const production *> _prods;
+	symbol_table _nonterms;
+	symbol_table _terms;
+
+	vector<int> _defines;
+	vector<int> _roots;
+	vector<item> _items;
+	vector<int> _kids;
+	vector<int> _stack;
+	int _depth;
+
+	size_t _words;
+	vector<char> _nullable;
+	vector<word> _first;
+	vector<word> _follow;
+	vector<char> _item_nullable;
+	vector<word> _item_first;
+	vector<word> _scratch;
+
+	vector<conflict> _conflicts;
+	vector<vector<size_t>> _left;
+};
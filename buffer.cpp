@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "buffer.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+void write_error( void )
+{
+	throw runtime_error( string( "write failed: " ) + strerror( errno ) );
+}
+
+}
+
+////////////////////////////////////////
+
+buffer_sink::~buffer_sink( void )
+{
+}
+
+////////////////////////////////////////
+
+buffer::buffer( int fd, size_t flush_size )
+	: _data( NULL ), _size( 0 ), _capacity( 0 ), _flush_size( flush_size ), _fd( fd ), _sink( NULL )
+{
+	grow( fd >= 0 ? flush_size : 4096 );
+}
+
+////////////////////////////////////////
+
+buffer::~buffer( void )
+{
+	try
+	{
+		flush();
+	}
+	catch ( ... )
+	{
+	}
+	free( _data );
+}
+
+////////////////////////////////////////
+
+void buffer::flush( void )
+{
+	if ( _sink )
+	{
+		_sink->write( _data, _size );
+		_size = 0;
+		return;
+	}
+	if ( _fd < 0 )
+		return;
+
+	const char *p = _data;
+	size_t left = _size;
+	while ( left > 0 )
+	{
+		ssize_t n = ::write( _fd, p, left );
+		if ( n < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			write_error();
+		}
+		p += n;
+		left -= size_t( n );
+	}
+	_size = 0;
+}
+
+////////////////////////////////////////
+
+void buffer::attach( int fd )
+{
+	flush();
+	_fd = fd;
+	_sink = NULL;
+}
+
+////////////////////////////////////////
+
+void buffer::attach( buffer_sink *sink )
+{
+	flush();
+	_fd = -1;
+	_sink = sink;
+}
+
+////////////////////////////////////////
+
+void buffer::grow( size_t n )
+{
+	size_t cap = _capacity ? _capacity : 4096;
+	while ( cap < _size + n )
+		cap *= 2;
+
+	char *tmp = static_cast<char *>( realloc( _data, cap ) );
+	if ( tmp == NULL )
+		throw bad_alloc();
+	_data = tmp;
+	_capacity = cap;
+}
+
+////////////////////////////////////////
+
+// Large appends go straight to the file together with whatever is
+// pending, in a single writev, instead of being copied first.
+void buffer::write_through( const char *s, size_t n )
+{
+	if ( _sink )
+	{
+		flush();
+		_sink->write( s, n );
+		return;
+	}
+
+	struct iovec iov[2];
+	iov[0].iov_base = _data;
+	iov[0].iov_len = _size;
+	iov[1].iov_base = const_cast<char *>( s );
+	iov[1].iov_len = n;
+
+	int first = 0;
+	while ( first < 2 )
+	{
+		ssize_t w = ::writev( _fd, iov + first, 2 - first );
+		if ( w < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			write_error();
+		}
+		size_t done = size_t( w );
+		while ( first < 2 && done >= iov[first].iov_len )
+		{
+			done -= iov[first].iov_len;
+			++first;
+		}
+		if ( first < 2 )
+		{
+			iov[first].iov_base = static_cast<char *>( iov[first].iov_base ) + done;
+			iov[first].iov_len -= done;
+		}
+	}
+	_size = 0;
+}
+
+////////////////////////////////////////
+
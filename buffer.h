@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "number.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+// Where a buffer writes its contents when that is not simply a file
+// descriptor (see gzip_sink).
+class buffer_sink
+{
+public:
+	virtual ~buffer_sink( void );
+	virtual void write( const char *data, size_t n ) = 0;
+};
+
+////////////////////////////////////////
+
+// Growable output buffer used by the draw backends.
+//
+// With a file descriptor (or a sink) the contents are written out in
+// large chunks whenever more than flush_size bytes are pending (and on
+// flush() or destruction).  Without one, everything stays in memory
+// for the caller to pick up with data()/size() or str().
+class buffer
+{
+public:
+	buffer( int fd = -1, size_t flush_size = 1 << 20 );
+	~buffer( void );
+
+	inline void append( const char *s, size_t n )
+	{
+		if ( _size + n > _capacity )
+		{
+			if ( n >= _flush_size && has_output() )
+			{
+				write_through( s, n );
+				return;
+			}
+			grow( n );
+		}
+		memcpy( _data + _size, s, n );
+		_size += n;
+		if ( _size >= _flush_size && has_output() )
+			flush();
+	}
+
+	inline void append( char c )
+	{
+		if ( _size + 1 > _capacity )
+			grow( 1 );
+		_data[_size++] = c;
+	}
+
+	inline buffer &operator<<( const char *s ) { append( s, strlen( s ) ); return *this; }
+	inline buffer &operator<<( const string &s ) { append( s.data(), s.size() ); return *this; }
+	inline buffer &operator<<( const number &n ) { append( n.data(), n.size() ); return *this; }
+	inline buffer &operator<<( char c ) { append( c ); return *this; }
+
+	inline const char *data( void ) const { return _data; }
+	inline size_t size( void ) const { return _size; }
+	inline string str( void ) const { return string( _data, _size ); }
+
+	// Drop the contents but keep the allocation for reuse.
+	inline void clear( void ) { _size = 0; }
+
+	void flush( void );
+
+	// Flush to the current file descriptor or sink, then switch to
+	// another one (or to none with -1), keeping the allocation.
+	void attach( int fd );
+	void attach( buffer_sink *sink );
+
+private:
+	buffer( const buffer & );
+	buffer &operator=( const buffer & );
+
+	inline bool has_output( void ) const { return _fd >= 0 || _sink; }
+
+	void grow( size_t n );
+	void write_through( const char *s, size_t n );
+
+	char *_data;
+	size_t _size;
+	size_t _capacity;
+	size_t _flush_size;
+	int _fd;
+	buffer_sink *_sink;
+};
+
+////////////////////////////////////////
+
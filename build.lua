@@ -2,15 +2,41 @@
 Include( SourceFile() )
 
 srcs = {
-	"main.cpp",
+	"node.cpp",
 	"print.cpp",
+	"buffer.cpp",
+	"escape.cpp",
+	"gzip.cpp",
 	"draw.cpp",
 	"svg.cpp",
 	"tikz.cpp",
 	"html.cpp",
+	"raster.cpp",
+	"font.cpp",
+	"deflate.cpp",
+	"png.cpp",
+	"pdf.cpp",
+	"json.cpp",
 	"render.cpp",
-	DParse( "grammar.g" ),
+	"record.cpp",
+	"split.cpp",
+	"tiles.cpp",
+	"spatial.cpp",
+	"xref.cpp",
+	"reach.cpp",
+	"simplify.cpp",
+	"analysis.cpp",
 }
 
-Executable( "draw_grammar", Compile( srcs ), LinkSys( "dparse" ) );
+-- Shared with the benchmark of the number formatter, which is only
+-- built when asked for ("make number_bench").
+numbers = Compile( "number.cpp" )
+
+-- Everything but main and the parser, shared with the benchmark of the
+-- render paths ("make render_bench").
+core = Compile( srcs )
+
+Executable( "draw_grammar", Compile( { "main.cpp", DParse( "grammar.g" ) } ), core, numbers, LinkSys( "dparse", "z" ) );
+OptExecutable( "number_bench", Compile( "number_bench.cpp" ), numbers );
+OptExecutable( "render_bench", Compile( "render_bench.cpp" ), core, numbers, LinkSys( "z" ) );
 
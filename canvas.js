@@ -0,0 +1,243 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+// Draws the .json display lists of draw_grammar (see json.h) into one
+// <canvas> per part, each painted when it first comes into view:
+//
+//   <div id="grammar"></div>
+//   <script src="canvas.js"></script>
+//   <script>drawGrammar( document.getElementById( "grammar" ), "grammar.json" );</script>
+//
+// doc is the parsed JSON, or a URL to fetch it from.
+
+function drawGrammar( container, doc )
+{
+	if ( typeof doc === "string" )
+	{
+		fetch( doc ).then( function( r ) { return r.json(); } ).then( function( d ) { drawGrammar( container, d ); } );
+		return;
+	}
+
+	// The classes of draw.h, colored as in svg.cpp's stylesheet.
+	var TEST = 10;
+	var colors = [ "black", "black", "black", "black", "black", "#A00000", "green", "black", "#3F00DD", "black", "black" ];
+
+	// Strokes reach a pixel past a part's box.  Browsers refuse canvases
+	// much bigger than max_side on a side.
+	var margin = 1;
+	var max_side = 16384;
+
+	function paint( canvas, part )
+	{
+		var w = part.w / doc.scale, h = part.h / doc.scale;
+		var ratio = Math.min( window.devicePixelRatio || 1, max_side / ( Math.max( w, h ) + 2 * margin ) );
+		canvas.width = Math.ceil( ( w + 2 * margin ) * ratio );
+		canvas.height = Math.ceil( ( h + 2 * margin ) * ratio );
+
+		var c = canvas.getContext( "2d" );
+		c.scale( ratio, ratio );
+		c.translate( margin, margin );
+		c.lineWidth = 2;
+		c.font = "bold 20px Courier, monospace";
+		c.textBaseline = "middle";
+		run( c, part.d, 0, part.d.length, 0, 0 );
+	}
+
+	// The number of arguments of each code.
+	var args = [ 3, 2, 1, 1, 2, 2, 1, 1, 1, 0, 5, 4, 5, 4, 4, 2, 0, 3 ];
+
+	// Where each group is in the lists, found in one pass up front
+	// since a part may draw a group from an earlier one.
+	var groups = [];
+	doc.parts.forEach( function( part )
+	{
+		var d = part.d, open = [];
+		for ( var i = 0; i < d.length; i += 1 + args[d[i]] )
+		{
+			if ( d[i] == 15 )
+			{
+				open.push( groups.length );
+				groups.push( { d: d, start: i + 3, end: d.length } );
+			}
+			else if ( d[i] == 16 )
+				groups[open.pop()].end = i;
+		}
+	} );
+
+	// Draw d[i, end) with the pen at (x, y), in 1/scale pixels.
+	function run( c, d, i, end, x, y )
+	{
+		var s = doc.scale;
+		var origins = [];
+		var cl, r;
+		while ( i < end )
+		{
+			switch ( d[i++] )
+			{
+				case 0:
+					cl = d[i++];
+					x += d[i++]; y += d[i++];
+					c.beginPath();
+					c.moveTo( x / s, y / s );
+					break;
+				case 1:
+					x += d[i++]; y += d[i++];
+					c.moveTo( x / s, y / s );
+					break;
+				case 2:
+					x += d[i++];
+					c.lineTo( x / s, y / s );
+					break;
+				case 3:
+					y += d[i++];
+					c.lineTo( x / s, y / s );
+					break;
+				case 4:
+					x += d[i++]; y += d[i++];
+					c.lineTo( x / s, y / s );
+					break;
+				case 5:
+					// Arcs that start out horizontal turn at the end of
+					// their first leg; the others turn at its side.
+					r = d[i++];
+					var a = d[i++];
+					var ex = ( a == 2 || a == 3 || a == 5 || a == 7 ) ? -r : r;
+					var ey = ( a == 0 || a == 2 || a == 4 || a == 5 ) ? -r : r;
+					if ( a < 4 )
+						c.arcTo( ( x + ex ) / s, y / s, ( x + ex ) / s, ( y + ey ) / s, r / s );
+					else
+						c.arcTo( x / s, ( y + ey ) / s, ( x + ex ) / s, ( y + ey ) / s, r / s );
+					x += ex; y += ey;
+					break;
+				case 6:
+					r = d[i++] / s;
+					c.lineTo( x / s + r, y / s + r / 2 );
+					c.lineTo( x / s + r, y / s - r / 2 );
+					c.closePath();
+					break;
+				case 7:
+					r = d[i++] / s;
+					c.lineTo( x / s - r, y / s - r / 2 );
+					c.lineTo( x / s - r, y / s + r / 2 );
+					c.closePath();
+					break;
+				case 8:
+					r = d[i++] / s;
+					c.lineTo( x / s - r / 2, y / s - r );
+					c.lineTo( x / s + r / 2, y / s - r );
+					c.closePath();
+					break;
+				case 9:
+					// Arrowheads are filled, everything else stroked.  Text
+					// leaves its own color as the fill.
+					if ( cl == 1 )
+					{
+						c.fillStyle = colors[cl];
+						c.fill();
+					}
+					else
+						c.stroke();
+					break;
+				case 10:
+					x += d[i++]; y += d[i++];
+					var bw = d[i++] / s, bh = d[i++] / s;
+					c.lineWidth = d[i++] == TEST ? 1 : 2;
+					c.strokeRect( x / s + 0.5, y / s + 0.5, bw, bh );
+					c.lineWidth = 2;
+					break;
+				case 11:
+					x += d[i++]; y += d[i++];
+					r = d[i++] / s;
+					i++;
+					c.beginPath();
+					c.arc( x / s + 0.5, y / s + 0.5, r, 0, 2 * Math.PI );
+					c.stroke();
+					break;
+				case 12:
+					x += d[i++]; y += d[i++];
+					var rw = d[i++] / s, rh = d[i++] / s;
+					var rx = x / s + 0.5, ry = y / s + 0.5, rr = rh / 2;
+					i++;
+					c.beginPath();
+					c.moveTo( rx + rr, ry );
+					c.arcTo( rx + rw, ry, rx + rw, ry + rh, rr );
+					c.arcTo( rx + rw, ry + rh, rx, ry + rh, rr );
+					c.arcTo( rx, ry + rh, rx, ry, rr );
+					c.arcTo( rx, ry, rx + rw, ry, rr );
+					c.closePath();
+					c.stroke();
+					break;
+				case 13:
+				case 14:
+					c.textAlign = d[i - 1] == 13 ? "left" : "center";
+					x += d[i++]; y += d[i++];
+					c.fillStyle = colors[d[i++]];
+					c.fillText( d[i++], x / s, y / s );
+					break;
+				case 15:
+					x += d[i++]; y += d[i++];
+					origins.push( x, y );
+					break;
+				case 16:
+					y = origins.pop(); x = origins.pop();
+					break;
+				case 17:
+					var g = groups[d[i++]];
+					x += d[i++]; y += d[i++];
+					run( c, g.d, g.start, g.end, x, y );
+					break;
+			}
+		}
+	}
+
+	var parts = doc.parts.map( function( part )
+	{
+		var canvas = document.createElement( "canvas" );
+		canvas.style.display = "block";
+		canvas.style.width = ( part.w / doc.scale + 2 * margin ) + "px";
+		canvas.style.height = ( part.h / doc.scale + 2 * margin ) + "px";
+		canvas.title = part.name;
+		if ( part.name )
+			canvas.id = part.name;
+		container.appendChild( canvas );
+		return canvas;
+	} );
+
+	if ( !( "IntersectionObserver" in window ) )
+	{
+		parts.forEach( function( canvas, i ) { paint( canvas, doc.parts[i] ); } );
+		return;
+	}
+
+	var observer = new IntersectionObserver( function( entries )
+	{
+		entries.forEach( function( e )
+		{
+			if ( e.isIntersecting )
+			{
+				observer.unobserve( e.target );
+				paint( e.target, doc.parts[parts.indexOf( e.target )] );
+			}
+		} );
+	}, { rootMargin: "100%" } );
+	parts.forEach( function( canvas ) { observer.observe( canvas ); } );
+}
@@ -27,6 +27,8 @@ CFlags( "-fPIC" )
 CXXFlags( "-msse", "-msse2", "-msse3" )
 CXXFlags( "-flax-vector-conversions" )
 CXXFlags( "--std=c++0x" )
+CXXFlags( "-pthread" )
+LDFlags( "-pthread" )
 if System() == "Darwin" then
 	CXXFlags( "--stdlib=libc++" )
 	LDFlags( "--std=c++0x" )
@@ -0,0 +1,463 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "deflate.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+const uint32_t adler_mod = 65521;
+const size_t block_symbols = 1 << 16;
+const size_t out_size = 256 * 1024;
+
+const int length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const int length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+// The order code length code lengths are sent in.
+const int code_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+////////////////////////////////////////
+
+// The length code of each match length.
+struct length_codes
+{
+	length_codes( void )
+	{
+		for ( int c = 0; c < 29; ++c )
+		{
+			int end = c == 28 ? 259 : length_base[c + 1];
+			for ( int l = length_base[c]; l < end; ++l )
+				code[l] = (unsigned char)( c );
+		}
+	}
+
+	unsigned char code[259];
+};
+
+const length_codes lengths;
+
+////////////////////////////////////////
+
+// Huffman code lengths for the frequencies, by Moffat and Katajainen's
+// in-place method.  While a code comes out longer than limit, the
+// frequencies are flattened and it is tried again.
+void code_lengths( const uint32_t *freq, int n, int limit, unsigned char *len )
+{
+	vector<uint32_t> f( freq, freq + n );
+	while ( true )
+	{
+		memset( len, 0, size_t( n ) );
+		vector< pair<uint32_t,int> > sorted;
+		for ( int i = 0; i < n; ++i )
+		{
+			if ( f[i] > 0 )
+				sorted.push_back( make_pair( f[i], i ) );
+		}
+		if ( sorted.empty() )
+			return;
+		if ( sorted.size() == 1 )
+		{
+			// A code needs two symbols to be complete.
+			len[sorted[0].second] = 1;
+			len[sorted[0].second == 0 ? 1 : 0] = 1;
+			return;
+		}
+		sort( sorted.begin(), sorted.end() );
+
+		int m = int( sorted.size() );
+		vector<uint32_t> a( m );
+		for ( int i = 0; i < m; ++i )
+			a[i] = sorted[i].first;
+
+		a[0] += a[1];
+		int root = 0, leaf = 2;
+		for ( int next = 1; next < m - 1; ++next )
+		{
+			if ( leaf >= m || a[root] < a[leaf] )
+			{
+				a[next] = a[root];
+				a[root++] = uint32_t( next );
+			}
+			else
+				a[next] = a[leaf++];
+
+			if ( leaf >= m || ( root < next && a[root] < a[leaf] ) )
+			{
+				a[next] += a[root];
+				a[root++] = uint32_t( next );
+			}
+			else
+				a[next] += a[leaf++];
+		}
+
+		a[m - 2] = 0;
+		for ( int next = m - 3; next >= 0; --next )
+			a[next] = a[a[next]] + 1;
+
+		int avail = 1, used = 0, depth = 0;
+		root = m - 2;
+		int next = m - 1;
+		while ( avail > 0 )
+		{
+			while ( root >= 0 && int( a[root] ) == depth )
+			{
+				++used;
+				--root;
+			}
+			while ( avail > used )
+			{
+				a[next--] = uint32_t( depth );
+				--avail;
+			}
+			avail = 2 * used;
+			++depth;
+			used = 0;
+		}
+
+		if ( int( a[0] ) <= limit )
+		{
+			for ( int i = 0; i < m; ++i )
+				len[sorted[i].second] = (unsigned char)( a[i] );
+			return;
+		}
+		for ( int i = 0; i < n; ++i )
+			f[i] = ( f[i] + 1 ) / 2;
+	}
+}
+
+////////////////////////////////////////
+
+// Canonical codes for the lengths, bit reversed since deflate sends
+// Huffman codes from their top bit.
+void canonical_codes( const unsigned char *len, int n, uint16_t *code )
+{
+	int count[16] = { 0 };
+	for ( int i = 0; i < n; ++i )
+		++count[len[i]];
+	count[0] = 0;
+
+	int next[16] = { 0 };
+	int c = 0;
+	for ( int b = 1; b < 16; ++b )
+	{
+		c = ( c + count[b - 1] ) << 1;
+		next[b] = c;
+	}
+
+	for ( int i = 0; i < n; ++i )
+	{
+		code[i] = 0;
+		if ( len[i] == 0 )
+			continue;
+		int v = next[len[i]]++;
+		int r = 0;
+		for ( int k = 0; k < len[i]; ++k )
+			r |= ( ( v >> k ) & 1 ) << ( len[i] - 1 - k );
+		code[i] = uint16_t( r );
+	}
+}
+
+////////////////////////////////////////
+
+// How many bytes from p on equal p[0].
+size_t same( const unsigned char *p, size_t n )
+{
+	size_t i = 1;
+#ifdef __SSE2__
+	__m128i v = _mm_set1_epi8( char( p[0] ) );
+	for ( ; i + 16 <= n; i += 16 )
+	{
+		int m = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i *>( p + i ) ), v ) );
+		if ( m != 0xFFFF )
+			return i + size_t( __builtin_ctz( ~m ) );
+	}
+#endif
+	while ( i < n && p[i] == p[0] )
+		++i;
+	return i;
+}
+
+}
+
+////////////////////////////////////////
+
+run_deflate::run_deflate( const function<void( const unsigned char *, size_t )> &out )
+	: _out( out ), _bits( 0 ), _count( 0 ), _last( -1 ), _run_value( 0 ), _run( 0 ), _adler_a( 1 ), _adler_b( 0 )
+{
+	memset( _lit_freq, 0, sizeof( _lit_freq ) );
+	_symbols.reserve( block_symbols + 1024 );
+	// Deflate with a 32K window, no dictionary, fastest.
+	_bytes.push_back( 0x78 );
+	_bytes.push_back( 0x01 );
+}
+
+////////////////////////////////////////
+
+void run_deflate::write( const unsigned char *p, size_t n, size_t lo, size_t hi )
+{
+	hi = std::min( hi, n );
+	lo = std::min( lo, hi );
+	put( 0, lo );
+	for ( size_t i = lo; i < hi; )
+	{
+		size_t r = same( p + i, hi - i );
+		put( p[i], r );
+		i += r;
+	}
+	put( 0, n - hi );
+}
+
+////////////////////////////////////////
+
+void run_deflate::finish( void )
+{
+	flush_run();
+	flush_block( true );
+	while ( _count > 0 )
+	{
+		_bytes.push_back( (unsigned char)( _bits ) );
+		_bits >>= 8;
+		_count = std::max( _count - 8, 0 );
+	}
+	_bytes.push_back( (unsigned char)( _adler_b >> 8 ) );
+	_bytes.push_back( (unsigned char)( _adler_b ) );
+	_bytes.push_back( (unsigned char)( _adler_a >> 8 ) );
+	_bytes.push_back( (unsigned char)( _adler_a ) );
+	drain();
+}
+
+////////////////////////////////////////
+
+// Adds n bytes of value v to the current run, and to the checksum: a
+// run adds n*v to the sum of bytes, and n*a + v*n(n+1)/2 to the sum of
+// sums.
+void run_deflate::put( unsigned v, size_t n )
+{
+	if ( n == 0 )
+		return;
+
+	uint64_t nm = n % adler_mod;
+	uint64_t tri = n % 2 == 0 ? ( ( n / 2 ) % adler_mod ) * ( ( n + 1 ) % adler_mod ) : nm * ( ( ( n + 1 ) / 2 ) % adler_mod );
+	_adler_b = uint32_t( ( _adler_b + nm * _adler_a + ( tri % adler_mod ) * v ) % adler_mod );
+	_adler_a = uint32_t( ( _adler_a + nm * v ) % adler_mod );
+
+	if ( v != _run_value )
+	{
+		flush_run();
+		_run_value = v;
+	}
+	_run += n;
+}
+
+////////////////////////////////////////
+
+// A run is the byte itself, unless the last byte already was that,
+// then matches of the byte before.  No match is left shorter than 3.
+void run_deflate::flush_run( void )
+{
+	size_t n = _run;
+	_run = 0;
+	if ( n == 0 )
+		return;
+
+	if ( int( _run_value ) != _last )
+	{
+		_symbols.push_back( uint16_t( _run_value ) );
+		++_lit_freq[_run_value];
+		_last = int( _run_value );
+		--n;
+	}
+	while ( n >= 3 )
+	{
+		size_t l = std::min( n, size_t( 258 ) );
+		if ( n - l > 0 && n - l < 3 )
+			l = n - 3;
+		_symbols.push_back( uint16_t( 256 + l ) );
+		++_lit_freq[257 + lengths.code[l]];
+		n -= l;
+	}
+	for ( ; n > 0; --n )
+	{
+		_symbols.push_back( uint16_t( _run_value ) );
+		++_lit_freq[_run_value];
+	}
+
+	if ( _symbols.size() >= block_symbols )
+		flush_block( false );
+}
+
+////////////////////////////////////////
+
+// A block with dynamic codes.  Only distance 1 is ever used, but the
+// distance code gets a second symbol to be complete.
+void run_deflate::flush_block( bool last )
+{
+	_lit_freq[256] = 1;
+	unsigned char lit_len[286];
+	code_lengths( _lit_freq, 286, 15, lit_len );
+	int hlit = 286;
+	while ( hlit > 257 && lit_len[hlit - 1] == 0 )
+		--hlit;
+	const int hdist = 2;
+
+	// The code lengths, run length coded with 16 (repeat the last 3-6
+	// times), 17 (3-10 zeros) and 18 (11-138 zeros).
+	unsigned char all[288];
+	memcpy( all, lit_len, size_t( hlit ) );
+	all[hlit] = 1;
+	all[hlit + 1] = 1;
+	int total = hlit + hdist;
+
+	vector< pair<int,int> > cl;
+	uint32_t cl_freq[19] = { 0 };
+	for ( int i = 0; i < total; )
+	{
+		int v = all[i];
+		int n = 1;
+		while ( i + n < total && all[i + n] == v )
+			++n;
+		i += n;
+		if ( v == 0 )
+		{
+			while ( n >= 11 )
+			{
+				int k = std::min( n, 138 );
+				cl.push_back( make_pair( 18, k - 11 ) );
+				n -= k;
+			}
+			if ( n >= 3 )
+			{
+				cl.push_back( make_pair( 17, n - 3 ) );
+				n = 0;
+			}
+		}
+		else
+		{
+			cl.push_back( make_pair( v, 0 ) );
+			--n;
+			while ( n >= 3 )
+			{
+				int k = std::min( n, 6 );
+				cl.push_back( make_pair( 16, k - 3 ) );
+				n -= k;
+			}
+		}
+		for ( ; n > 0; --n )
+			cl.push_back( make_pair( v, 0 ) );
+	}
+	for ( size_t i = 0; i < cl.size(); ++i )
+		++cl_freq[cl[i].first];
+
+	unsigned char cl_len[19];
+	uint16_t cl_code[19];
+	code_lengths( cl_freq, 19, 7, cl_len );
+	canonical_codes( cl_len, 19, cl_code );
+	int hclen = 19;
+	while ( hclen > 4 && cl_len[code_order[hclen - 1]] == 0 )
+		--hclen;
+
+	bits( last ? 1 : 0, 1 );
+	bits( 2, 2 );
+	bits( uint32_t( hlit - 257 ), 5 );
+	bits( uint32_t( hdist - 1 ), 5 );
+	bits( uint32_t( hclen - 4 ), 4 );
+	for ( int i = 0; i < hclen; ++i )
+		bits( cl_len[code_order[i]], 3 );
+	for ( size_t i = 0; i < cl.size(); ++i )
+	{
+		int s = cl[i].first;
+		bits( cl_code[s], cl_len[s] );
+		if ( s == 16 )
+			bits( uint32_t( cl[i].second ), 2 );
+		else if ( s == 17 )
+			bits( uint32_t( cl[i].second ), 3 );
+		else if ( s == 18 )
+			bits( uint32_t( cl[i].second ), 7 );
+	}
+
+	// Distance 1 is code 0, which canonically is a single 0 bit.
+	uint16_t lit_code[286];
+	canonical_codes( lit_len, 286, lit_code );
+	for ( size_t i = 0; i < _symbols.size(); ++i )
+	{
+		unsigned s = _symbols[i];
+		if ( s < 256 )
+			bits( lit_code[s], lit_len[s] );
+		else
+		{
+			int l = int( s - 256 );
+			int c = lengths.code[l];
+			bits( lit_code[257 + c], lit_len[257 + c] );
+			if ( length_extra[c] > 0 )
+				bits( uint32_t( l - length_base[c] ), length_extra[c] );
+			bits( 0, 1 );
+		}
+	}
+	bits( lit_code[256], lit_len[256] );
+
+	_symbols.clear();
+	memset( _lit_freq, 0, sizeof( _lit_freq ) );
+}
+
+////////////////////////////////////////
+
+void run_deflate::bits( uint32_t v, int n )
+{
+	_bits |= uint64_t( v ) << _count;
+	_count += n;
+	if ( _count >= 32 )
+	{
+		for ( int i = 0; i < 4; ++i )
+		{
+			_bytes.push_back( (unsigned char)( _bits ) );
+			_bits >>= 8;
+		}
+		_count -= 32;
+		if ( _bytes.size() >= out_size )
+			drain();
+	}
+}
+
+////////////////////////////////////////
+
+void run_deflate::drain( void )
+{
+	if ( !_bytes.empty() )
+		_out( &_bytes[0], _bytes.size() );
+	_bytes.clear();
+}
+
+////////////////////////////////////////
+
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+////////////////////////////////////////
+
+// A zlib stream coded for speed on filtered images, which are mostly
+// long runs of zeros.  A run of one byte value becomes a literal and a
+// match at distance 1, and no other matches are looked for.  Each block
+// gets Huffman codes of its own, so a long run costs a couple of bits
+// per 258 bytes.  Compressed bytes are handed to out as they pile up.
+class run_deflate
+{
+public:
+	run_deflate( const function<void( const unsigned char *, size_t )> &out );
+
+	// Compress n bytes, of which only those in [lo, hi) may be other
+	// than zero; the rest are not looked at.
+	void write( const unsigned char *p, size_t n, size_t lo, size_t hi );
+
+	// The last block and the checksum.
+	void finish( void );
+
+private:
+	run_deflate( const run_deflate & );
+	run_deflate &operator=( const run_deflate & );
+
+	void put( unsigned v, size_t n );
+	void flush_run( void );
+	void flush_block( bool last );
+	void bits( uint32_t v, int n );
+	void drain( void );
+
+	function<void( const unsigned char *, size_t )> _out;
+	vector<unsigned char> _bytes;
+	uint64_t _bits;
+	int _count;
+
+	// Literals are 0-255, matches 256 + length.
+	vector<uint16_t> _symbols;
+	uint32_t _lit_freq[286];
+
+	int _last;
+	unsigned _run_value;
+	size_t _run;
+
+	uint32_t _adler_a;
+	uint32_t _adler_b;
+};
+
+////////////////////////////////////////
+
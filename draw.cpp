@@ -31,8 +31,8 @@ using namespace std;
 
 ////////////////////////////////////////
 
-draw::draw( ostream &o )
-	: out( o ), dx( 1, 0.F ), dy( 1, 0.F )
+draw::draw( buffer &o )
+	: out( o ), precision( 3 ), open_path( -1 ), dx( 1, 0.F ), dy( 1, 0.F )
 {
 }
 
@@ -62,333 +62,104 @@ void draw::pop_translate( void )
 
 ////////////////////////////////////////
 
+void draw::subpath_begin( float x, float y, Class cl )
+{
+	static_subpath_begin( *this, x, y, cl );
+}
+
+////////////////////////////////////////
+
+void draw::close_path( void )
+{
+	static_close_path( *this );
+}
+
+////////////////////////////////////////
+
 void draw::hline( const point &p1, const point &p2, Class cl )
 {
-	path_begin( p1.x, p1.y, cl );
-	path_h_to( p2.x );
-	path_end();
+	static_hline( *this, p1, p2, cl );
 }
 
 ////////////////////////////////////////
 
 void draw::vline( const point &p1, const point &p2, Class cl )
 {
-	path_begin( p1.x, p1.y, cl );
-	path_v_to( p2.y );
-	path_end();
+	static_vline( *this, p1, p2, cl );
 }
 
 ////////////////////////////////////////
 
 void draw::path( const point &p1, const point &p2, float r, Arc dir, Class cl )
 {
-	path_begin( p1.x, p1.y, cl );
-	switch ( dir )
-	{
-		case RIGHT_UP:
-		case RIGHT_DOWN:
-			path_h_to( p2.x - r );
-			break;
-
-		case LEFT_UP:
-		case LEFT_DOWN:
-			path_h_to( p2.x + r );
-			break;
-
-		case UP_RIGHT:
-		case UP_LEFT:
-			path_v_to( p2.y + r );
-			break;
-
-		case DOWN_RIGHT:
-		case DOWN_LEFT:
-			path_v_to( p2.y - r );
-			break;
-	}
-
-	path_arc( r, dir );
-	switch ( dir )
-	{
-		case RIGHT_UP:
-		case RIGHT_DOWN:
-		case LEFT_UP:
-		case LEFT_DOWN:
-			path_v_to( p2.y );
-			break;
-
-		case UP_RIGHT:
-		case UP_LEFT:
-		case DOWN_RIGHT:
-		case DOWN_LEFT:
-			path_h_to( p2.x );
-			break;
-	}
-	path_end();
+	static_path( *this, p1, p2, r, dir, cl );
 }
 
 ////////////////////////////////////////
 
 void draw::path( Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl )
 {
-	path_begin( p1.x, p1.y, cl );
-
-	switch ( d1 )
-	{
-		case RIGHT:
-			switch ( d2 )
-			{
-				case RIGHT:
-					if ( p1.x < p2.x )
-					{
-						if ( p1.y < p2.y )
-						{
-							path_arc( r, RIGHT_DOWN );
-							path_v_to( p2.y - r );
-							path_arc( r, DOWN_RIGHT );
-							path_h_to( p2.x );
-						}
-						else
-						{
-							path_h_to( p2.x - r*2 );
-							path_arc( r, RIGHT_UP );
-							path_v_to( p2.y + r );
-							path_arc( r, UP_RIGHT );
-						}
-					}
-					break;
-
-				case LEFT:
-					path_h_to( std::max( p1.x, p2.x ) );
-					if ( p1.y < p2.y )
-					{
-						path_arc( r, RIGHT_DOWN );
-						path_v_to( p2.y - r );
-						path_arc( r, DOWN_LEFT );
-						path_h_to( p2.x );
-					}
-					else
-					{
-						path_h_to( std::max( p1.x, p2.x ) );
-						path_arc( r, RIGHT_UP );
-						path_v_to( p2.y + r );
-						path_arc( r, UP_LEFT );
-						path_h_to( p2.x );
-					}
-					break;
-
-				case UP:
-					path_h_to( p2.x - r );
-					path_arc( r, RIGHT_UP );
-					path_v_to( p2.y );
-					break;
-
-				case DOWN:
-					path_h_to( p2.x - r );
-					path_arc( r, RIGHT_DOWN );
-					path_v_to( p2.y );
-					break;
-
-
-				default:
-					break;
-			}
-			break;
-
-		case LEFT:
-			switch ( d2 )
-			{
-				case RIGHT:
-					path_h_to( std::min( p1.x, p2.x ) );
-					if ( p1.y < p2.y )
-					{
-						path_arc( r, LEFT_DOWN );
-						path_v_to( p2.y - r );
-						path_arc( r, DOWN_RIGHT );
-						path_h_to( p2.x );
-					}
-					else
-					{
-						path_arc( r, LEFT_UP );
-						path_v_to( p2.y + r );
-						path_arc( r, UP_RIGHT );
-						path_h_to( p2.x );
-					}
-					break;
-
-				case LEFT:
-					if ( p1.x < p2.x )
-					{
-						if ( p1.y < p2.y )
-						{
-							path_arc( r, LEFT_DOWN );
-							path_v_to( p2.y - r );
-							path_arc( r, DOWN_LEFT );
-							path_h_to( p2.x );
-						}
-						else
-						{
-							path_h_to( p2.x - r*2 );
-							path_arc( r, LEFT_UP );
-							path_v_to( p2.y + r );
-							path_arc( r, UP_LEFT );
-						}
-					}
-					else
-					{
-						if ( p1.y < p2.y )
-						{
-							path_arc( r, LEFT_DOWN );
-							path_v_to( p2.y - r );
-							path_arc( r, DOWN_LEFT );
-							path_h_to( p2.x );
-						}
-						else
-						{
-							path_h_to( p2.x + r*2 );
-							path_arc( r, LEFT_UP );
-							path_v_to( p2.y + r );
-							path_arc( r, UP_LEFT );
-						}
-					}
-					break;
-
-				case UP:
-					path_h_to( p2.x - r );
-					path_arc( r, LEFT_UP );
-					path_v_to( p2.y );
-					break;
-
-				case DOWN:
-					path_h_to( p2.x + r );
-					path_arc( r, LEFT_DOWN );
-					path_v_to( p2.y );
-					break;
-
-				case NONE:
-					break;
-			}
-			break;
-
-		case UP:
-			switch ( d2 )
-			{
-				case RIGHT:
-					path_v_to( p2.y + r );
-					path_arc( r, UP_RIGHT );
-					path_h_to( p2.x );
-					break;
-
-				default:
-					throw runtime_error( "Not yet implemented" );
-			}
-			break;
-
-		case DOWN:
-			switch ( d2 )
-			{
-				case RIGHT:
-					path_v_to( p2.y - r );
-					path_arc( r, DOWN_RIGHT );
-					path_h_to( p2.x );
-					break;
-
-				case LEFT:
-					path_v_to( p2.y - r );
-					path_arc( r, DOWN_LEFT );
-					path_h_to( p2.x );
-					break;
-
-				case UP:
-					path_v_to( std::max( p1.y, p2.y ) );
-					if ( p2.x < p1.x )
-					{
-						path_arc( r, DOWN_LEFT );
-						path_h_to( p2.x+r );
-						path_arc( r, LEFT_UP );
-					}
-					else
-					{
-						path_arc( r, DOWN_RIGHT );
-						path_h_to( p2.x-r );
-						path_arc( r, RIGHT_UP );
-					}
-					path_v_to( p2.y );
-					break;
-
-				case DOWN:
-					path_v_to( std::max( p1.y, p2.y ) - r*2 );
-					if ( p2.x < p1.x )
-					{
-						path_arc( r, DOWN_LEFT );
-						path_h_to( p2.x+r );
-						path_arc( r, LEFT_DOWN );
-					}
-					else
-					{
-						path_arc( r, DOWN_RIGHT );
-						path_h_to( p2.x-r );
-						path_arc( r, RIGHT_DOWN );
-					}
-					break;
-
-				case NONE:
-					break;
-			}
-			break;
-
-		default:
-			break;
-	}
-
-	path_end();
+	static_path( *this, d1, p1, p2, d2, r, cl );
 }
 
 ////////////////////////////////////////
 
 void draw::arrow_left( const point &p, float l, float size, Class cl1, Class cl2 )
 {
-	if ( l > size/2 )
-	{
-		path_begin( p.x, p.y, cl1 );
-		path_h_by( -l + size/2 );
-		path_end();
-	}
-
-	path_begin( p.x - l, p.y, cl2 );
-	path_arrow_left( size );
-	path_end();
+	static_arrow_left( *this, p, l, size, cl1, cl2 );
 }
 
 ////////////////////////////////////////
 
 void draw::arrow_right( const point &p, float l, float size, Class cl1, Class cl2 )
 {
-	if ( l > size/2 )
-	{
-		path_begin( p.x, p.y, cl1 );
-		path_h_by( l - size/2 );
-		path_end();
-	}
-
-	path_begin( p.x + l, p.y, cl2 );
-	path_arrow_right( size );
-	path_end();
+	static_arrow_right( *this, p, l, size, cl1, cl2 );
 }
 
 ////////////////////////////////////////
 
 void draw::arrow_down( const point &p, float l, float size, Class cl1, Class cl2 )
 {
-	if ( l > size/2 )
-	{
-		path_begin( p.x, p.y, cl1 );
-		path_v_by( l - size/2 );
-		path_end();
-	}
-
-	path_begin( p.x, p.y + l, cl2 );
-	path_arrow_down( size );
-	path_end();
+	static_arrow_down( *this, p, l, size, cl1, cl2 );
+}
+
+////////////////////////////////////////
+
+void draw::arrow_head( float x, float y, Direction d, float size, Class cl )
+{
+	static_arrow_head( *this, x, y, d, size, cl );
+}
+
+////////////////////////////////////////
+
+void draw::part_begin( float x, float y, float w, float h, const string &name )
+{
+}
+
+////////////////////////////////////////
+
+void draw::part_end( void )
+{
+}
+
+////////////////////////////////////////
+
+bool draw::reuses_groups( void ) const
+{
+	return false;
+}
+
+////////////////////////////////////////
+
+bool draw::group_begin( const string &key, float x, float y )
+{
+	return false;
+}
+
+////////////////////////////////////////
+
+void draw::group_end( void )
+{
 }
 
 ////////////////////////////////////////
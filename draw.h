@@ -25,6 +25,10 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "buffer.h"
 
 using namespace std;
 
@@ -119,9 +123,11 @@ struct point
 class draw
 {
 public:
-	draw( ostream &out );
+	draw( buffer &out );
 	virtual ~draw( void );
 
+	void set_precision( int decimals ) { precision = decimals; }
+
 	virtual void begin( const string &title ) = 0;
 	virtual void end( void ) = 0;
 
@@ -134,6 +140,13 @@ public:
 	virtual void link_begin( const string &name ) = 0;
 	virtual void link_end() = 0;
 
+	// The title and each production are drawn between part_begin()
+	// and part_end(), with the box of the part in current coordinates.
+	// Backends that lay parts out separately use them; by default they
+	// do nothing.
+	virtual void part_begin( float x, float y, float w, float h, const string &name );
+	virtual void part_end( void );
+
 	virtual void circle( float x, float y, float r, Class cl ) = 0;
 	virtual void box( float x, float y, float w, float h, Class cl ) = 0;
 	virtual void round( float x, float y, float w, float h, Class c ) = 0;
@@ -150,8 +163,21 @@ public:
 	virtual void arrow_left( const point &p, float l, float size, Class cl1, Class cl2 );
 	virtual void arrow_right( const point &p, float l, float size, Class cl1, Class cl2 );
 	virtual void arrow_down( const point &p, float l, float size, Class cl1, Class cl2 );
+	virtual void arrow_head( float x, float y, Direction d, float size, Class cl );
+
+	// Repeated subdiagrams.  group_begin() is called before drawing a
+	// subtree whose appearance is fully described by key, with (x,y)
+	// its top left corner.  A backend that can place a copy of an
+	// earlier group with the same key does so and returns true, and the
+	// subtree is skipped.  Otherwise the subtree is drawn, followed by
+	// group_end().  By default everything is drawn, and backends say
+	// with reuses_groups() whether groups are worth looking for.
+	virtual bool reuses_groups( void ) const;
+	virtual bool group_begin( const string &key, float x, float y );
+	virtual void group_end( void );
 
 	virtual void path_begin( float x, float y, Class cl ) = 0;
+	virtual void path_move( float x, float y ) = 0;
 
 	virtual void path_h_by( float x ) = 0;
 	virtual void path_v_by( float y ) = 0;
@@ -166,12 +192,405 @@ public:
 	virtual void path_end( void ) = 0;
 
 protected:
-	ostream &out;
+	buffer &out;
 
 	inline float xx( float x ) { return x - dx.back(); }
 	inline float yy( float y ) { return y - dy.back(); }
 
+	inline number num( float v ) const { return number( v, precision ); }
+
+	// The line, path and arrow helpers leave their path open so that
+	// the next segment of the same class is appended as another
+	// subpath.  Backends call close_path() before drawing anything else.
+	void subpath_begin( float x, float y, Class cl );
+	void close_path( void );
+
+	// Non-virtual versions of the helpers above.  They are instantiated
+	// over a concrete backend so its path calls can be bound statically;
+	// the virtual helpers are the same code instantiated over draw.
+	template <class DC> static void static_subpath_begin( DC &dc, float x, float y, Class cl );
+	template <class DC> static void static_close_path( DC &dc );
+	template <class DC> static void static_hline( DC &dc, const point &p1, const point &p2, Class cl );
+	template <class DC> static void static_vline( DC &dc, const point &p1, const point &p2, Class cl );
+	template <class DC> static void static_path( DC &dc, const point &p1, const point &p2, float r, Arc dir, Class cl );
+	template <class DC> static void static_path( DC &dc, Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl );
+	template <class DC> static void static_arrow_left( DC &dc, const point &p, float l, float size, Class cl1, Class cl2 );
+	template <class DC> static void static_arrow_right( DC &dc, const point &p, float l, float size, Class cl1, Class cl2 );
+	template <class DC> static void static_arrow_down( DC &dc, const point &p, float l, float size, Class cl1, Class cl2 );
+	template <class DC> static void static_arrow_head( DC &dc, float x, float y, Direction d, float size, Class cl );
+
+	int precision;
+	int open_path;
+
 	vector<float> dx;
 	vector<float> dy;
 };
 
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_subpath_begin( DC &dc, float x, float y, Class cl )
+{
+	if ( dc.open_path == int( cl ) )
+		dc.path_move( x, y );
+	else
+	{
+		static_close_path( dc );
+		dc.path_begin( x, y, cl );
+		dc.open_path = int( cl );
+	}
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_close_path( DC &dc )
+{
+	if ( dc.open_path >= 0 )
+	{
+		dc.path_end();
+		dc.open_path = -1;
+	}
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_hline( DC &dc, const point &p1, const point &p2, Class cl )
+{
+	static_subpath_begin( dc, p1.x, p1.y, cl );
+	dc.path_h_to( p2.x );
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_vline( DC &dc, const point &p1, const point &p2, Class cl )
+{
+	static_subpath_begin( dc, p1.x, p1.y, cl );
+	dc.path_v_to( p2.y );
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_path( DC &dc, const point &p1, const point &p2, float r, Arc dir, Class cl )
+{
+	static_subpath_begin( dc, p1.x, p1.y, cl );
+	switch ( dir )
+	{
+		case RIGHT_UP:
+		case RIGHT_DOWN:
+			dc.path_h_to( p2.x - r );
+			break;
+
+		case LEFT_UP:
+		case LEFT_DOWN:
+			dc.path_h_to( p2.x + r );
+			break;
+
+		case UP_RIGHT:
+		case UP_LEFT:
+			dc.path_v_to( p2.y + r );
+			break;
+
+		case DOWN_RIGHT:
+		case DOWN_LEFT:
+			dc.path_v_to( p2.y - r );
+			break;
+	}
+
+	dc.path_arc( r, dir );
+	switch ( dir )
+	{
+		case RIGHT_UP:
+		case RIGHT_DOWN:
+		case LEFT_UP:
+		case LEFT_DOWN:
+			dc.path_v_to( p2.y );
+			break;
+
+		case UP_RIGHT:
+		case UP_LEFT:
+		case DOWN_RIGHT:
+		case DOWN_LEFT:
+			dc.path_h_to( p2.x );
+			break;
+	}
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_path( DC &dc, Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl )
+{
+	static_subpath_begin( dc, p1.x, p1.y, cl );
+
+	switch ( d1 )
+	{
+		case RIGHT:
+			switch ( d2 )
+			{
+				case RIGHT:
+					if ( p1.x < p2.x )
+					{
+						if ( p1.y < p2.y )
+						{
+							dc.path_arc( r, RIGHT_DOWN );
+							dc.path_v_to( p2.y - r );
+							dc.path_arc( r, DOWN_RIGHT );
+							dc.path_h_to( p2.x );
+						}
+						else
+						{
+							dc.path_h_to( p2.x - r*2 );
+							dc.path_arc( r, RIGHT_UP );
+							dc.path_v_to( p2.y + r );
+							dc.path_arc( r, UP_RIGHT );
+						}
+					}
+					break;
+
+				case LEFT:
+					dc.path_h_to( std::max( p1.x, p2.x ) );
+					if ( p1.y < p2.y )
+					{
+						dc.path_arc( r, RIGHT_DOWN );
+						dc.path_v_to( p2.y - r );
+						dc.path_arc( r, DOWN_LEFT );
+						dc.path_h_to( p2.x );
+					}
+					else
+					{
+						dc.path_h_to( std::max( p1.x, p2.x ) );
+						dc.path_arc( r, RIGHT_UP );
+						dc.path_v_to( p2.y + r );
+						dc.path_arc( r, UP_LEFT );
+						dc.path_h_to( p2.x );
+					}
+					break;
+
+				case UP:
+					dc.path_h_to( p2.x - r );
+					dc.path_arc( r, RIGHT_UP );
+					dc.path_v_to( p2.y );
+					break;
+
+				case DOWN:
+					dc.path_h_to( p2.x - r );
+					dc.path_arc( r, RIGHT_DOWN );
+					dc.path_v_to( p2.y );
+					break;
+
+
+				default:
+					break;
+			}
+			break;
+
+		case LEFT:
+			switch ( d2 )
+			{
+				case RIGHT:
+					dc.path_h_to( std::min( p1.x, p2.x ) );
+					if ( p1.y < p2.y )
+					{
+						dc.path_arc( r, LEFT_DOWN );
+						dc.path_v_to( p2.y - r );
+						dc.path_arc( r, DOWN_RIGHT );
+						dc.path_h_to( p2.x );
+					}
+					else
+					{
+						dc.path_arc( r, LEFT_UP );
+						dc.path_v_to( p2.y + r );
+						dc.path_arc( r, UP_RIGHT );
+						dc.path_h_to( p2.x );
+					}
+					break;
+
+				case LEFT:
+					if ( p1.x < p2.x )
+					{
+						if ( p1.y < p2.y )
+						{
+							dc.path_arc( r, LEFT_DOWN );
+							dc.path_v_to( p2.y - r );
+							dc.path_arc( r, DOWN_LEFT );
+							dc.path_h_to( p2.x );
+						}
+						else
+						{
+							dc.path_h_to( p2.x - r*2 );
+							dc.path_arc( r, LEFT_UP );
+							dc.path_v_to( p2.y + r );
+							dc.path_arc( r, UP_LEFT );
+						}
+					}
+					else
+					{
+						if ( p1.y < p2.y )
+						{
+							dc.path_arc( r, LEFT_DOWN );
+							dc.path_v_to( p2.y - r );
+							dc.path_arc( r, DOWN_LEFT );
+							dc.path_h_to( p2.x );
+						}
+						else
+						{
+							dc.path_h_to( p2.x + r*2 );
+							dc.path_arc( r, LEFT_UP );
+							dc.path_v_to( p2.y + r );
+							dc.path_arc( r, UP_LEFT );
+						}
+					}
+					break;
+
+				case UP:
+					dc.path_h_to( p2.x - r );
+					dc.path_arc( r, LEFT_UP );
+					dc.path_v_to( p2.y );
+					break;
+
+				case DOWN:
+					dc.path_h_to( p2.x + r );
+					dc.path_arc( r, LEFT_DOWN );
+					dc.path_v_to( p2.y );
+					break;
+
+				case NONE:
+					break;
+			}
+			break;
+
+		case UP:
+			switch ( d2 )
+			{
+				case RIGHT:
+					dc.path_v_to( p2.y + r );
+					dc.path_arc( r, UP_RIGHT );
+					dc.path_h_to( p2.x );
+					break;
+
+				default:
+					throw runtime_error( "Not yet implemented" );
+			}
+			break;
+
+		case DOWN:
+			switch ( d2 )
+			{
+				case RIGHT:
+					dc.path_v_to( p2.y - r );
+					dc.path_arc( r, DOWN_RIGHT );
+					dc.path_h_to( p2.x );
+					break;
+
+				case LEFT:
+					dc.path_v_to( p2.y - r );
+					dc.path_arc( r, DOWN_LEFT );
+					dc.path_h_to( p2.x );
+					break;
+
+				case UP:
+					dc.path_v_to( std::max( p1.y, p2.y ) );
+					if ( p2.x < p1.x )
+					{
+						dc.path_arc( r, DOWN_LEFT );
+						dc.path_h_to( p2.x+r );
+						dc.path_arc( r, LEFT_UP );
+					}
+					else
+					{
+						dc.path_arc( r, DOWN_RIGHT );
+						dc.path_h_to( p2.x-r );
+						dc.path_arc( r, RIGHT_UP );
+					}
+					dc.path_v_to( p2.y );
+					break;
+
+				case DOWN:
+					dc.path_v_to( std::max( p1.y, p2.y ) - r*2 );
+					if ( p2.x < p1.x )
+					{
+						dc.path_arc( r, DOWN_LEFT );
+						dc.path_h_to( p2.x+r );
+						dc.path_arc( r, LEFT_DOWN );
+					}
+					else
+					{
+						dc.path_arc( r, DOWN_RIGHT );
+						dc.path_h_to( p2.x-r );
+						dc.path_arc( r, RIGHT_DOWN );
+					}
+					break;
+
+				case NONE:
+					break;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_arrow_left( DC &dc, const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	if ( l > size/2 )
+	{
+		static_subpath_begin( dc, p.x, p.y, cl1 );
+		dc.path_h_by( -l + size/2 );
+	}
+
+	dc.arrow_head( p.x - l, p.y, LEFT, size, cl2 );
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_arrow_right( DC &dc, const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	if ( l > size/2 )
+	{
+		static_subpath_begin( dc, p.x, p.y, cl1 );
+		dc.path_h_by( l - size/2 );
+	}
+
+	dc.arrow_head( p.x + l, p.y, RIGHT, size, cl2 );
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_arrow_down( DC &dc, const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	if ( l > size/2 )
+	{
+		static_subpath_begin( dc, p.x, p.y, cl1 );
+		dc.path_v_by( l - size/2 );
+	}
+
+	dc.arrow_head( p.x, p.y + l, DOWN, size, cl2 );
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void draw::static_arrow_head( DC &dc, float x, float y, Direction d, float size, Class cl )
+{
+	static_subpath_begin( dc, x, y, cl );
+	switch ( d )
+	{
+		case LEFT: dc.path_arrow_left( size ); break;
+		case RIGHT: dc.path_arrow_right( size ); break;
+		case DOWN: dc.path_arrow_down( size ); break;
+		default: throw runtime_error( "Not yet implemented" );
+	}
+}
+
+////////////////////////////////////////
+
@@ -0,0 +1,180 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "escape.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+// A set of (at most 16) characters that need escaping.
+class char_set
+{
+public:
+	char_set( const char *chars )
+		: _count( strlen( chars ) )
+	{
+		memset( _member, 0, sizeof( _member ) );
+		for ( size_t i = 0; i < _count; ++i )
+		{
+			_member[static_cast<unsigned char>( chars[i] )] = true;
+#ifdef __SSE2__
+			_chars[i] = _mm_set1_epi8( chars[i] );
+#endif
+		}
+	}
+
+	// Return the first member in [p,end), or end.  Runs without any
+	// are skipped 16 bytes at a time.
+	const char *find( const char *p, const char *end ) const
+	{
+#ifdef __SSE2__
+		for ( ; end - p >= 16; p += 16 )
+		{
+			__m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( p ) );
+			__m128i hit = _mm_cmpeq_epi8( v, _chars[0] );
+			for ( size_t i = 1; i < _count; ++i )
+				hit = _mm_or_si128( hit, _mm_cmpeq_epi8( v, _chars[i] ) );
+			int mask = _mm_movemask_epi8( hit );
+			if ( mask )
+				return p + __builtin_ctz( mask );
+		}
+#endif
+		while ( p < end && !_member[static_cast<unsigned char>( *p )] )
+			++p;
+		return p;
+	}
+
+private:
+	size_t _count;
+	bool _member[256];
+#ifdef __SSE2__
+	__m128i _chars[16];
+#endif
+};
+
+////////////////////////////////////////
+
+const char *xml_entity( char c )
+{
+	switch ( c )
+	{
+		case '&': return "&amp;";
+		case '<': return "&lt;";
+		case '>': return "&gt;";
+		case '"': return "&quot;";
+		case '\'': return "&#39;";
+		default: return "";
+	}
+}
+
+////////////////////////////////////////
+
+const char *tex_command( char c )
+{
+	switch ( c )
+	{
+		case '{': return "\\{";
+		case '}': return "\\}";
+		case '_': return "\\_";
+		case '&': return "\\&";
+		case '%': return "\\%";
+		case '#': return "\\#";
+		case '$': return "\\$";
+		case '~': return "\\textasciitilde{}";
+		case '^': return "\\textasciicircum{}";
+		case '\\': return "\\textbackslash{}";
+		default: return "";
+	}
+}
+
+////////////////////////////////////////
+
+// Copy clean runs straight into out and replace each special character.
+template <typename Replace>
+void escape( buffer &out, const char *s, size_t n, const char_set &set, Replace replace )
+{
+	const char *end = s + n;
+	while ( s < end )
+	{
+		const char *p = set.find( s, end );
+		out.append( s, size_t( p - s ) );
+		if ( p == end )
+			break;
+		out << replace( *p );
+		s = p + 1;
+	}
+}
+
+}
+
+////////////////////////////////////////
+
+void xml_escape( buffer &out, const char *s, size_t n )
+{
+	static const char_set specials( "&<>\"'" );
+	escape( out, s, n, specials, xml_entity );
+}
+
+////////////////////////////////////////
+
+void tex_escape( buffer &out, const char *s, size_t n )
+{
+	static const char_set specials( "{}_&%#$~^\\" );
+	escape( out, s, n, specials, tex_command );
+}
+
+////////////////////////////////////////
+
+void json_escape( buffer &out, const char *s, size_t n )
+{
+	static const char hex[] = "0123456789abcdef";
+	const char *end = s + n;
+	while ( s < end )
+	{
+		const char *p = s;
+		while ( p < end && static_cast<unsigned char>( *p ) >= 0x20 && *p != '"' && *p != '\\' )
+			++p;
+		out.append( s, size_t( p - s ) );
+		if ( p == end )
+			break;
+		if ( *p == '"' || *p == '\\' )
+			out << '\\' << *p;
+		else
+		{
+			char u[6] = { '\\', 'u', '0', '0', hex[( *p >> 4 ) & 0xF], hex[*p & 0xF] };
+			out.append( u, 6 );
+		}
+		s = p + 1;
+	}
+}
+
+////////////////////////////////////////
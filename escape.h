@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "buffer.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+// Escape text for XML (SVG and HTML): & < > " and ' become entities.
+void xml_escape( buffer &out, const char *s, size_t n );
+
+// Escape text for LaTeX: the special characters become commands.
+void tex_escape( buffer &out, const char *s, size_t n );
+
+// Escape text for a JSON string: " and \ are backslashed, and control
+// characters become \u escapes.
+void json_escape( buffer &out, const char *s, size_t n );
+
+////////////////////////////////////////
+
+inline void xml_escape( buffer &out, const string &s )
+{
+	xml_escape( out, s.data(), s.size() );
+}
+
+inline void tex_escape( buffer &out, const string &s )
+{
+	tex_escape( out, s.data(), s.size() );
+}
+
+inline void json_escape( buffer &out, const string &s )
+{
+	json_escape( out, s.data(), s.size() );
+}
+
+////////////////////////////////////////
+
@@ -0,0 +1,457 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "font.h"
+#include "raster.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+// Strokes of the characters from ' ' to '~', on a grid where capitals
+// span 0 to 8 across 0 to 6, the x-height is 3 and descenders reach
+// 10.5.  Polylines are separated by ';' and are lists of x,y points;
+// "a cx,cy rx,ry a0,a1" continues the polyline along an elliptical arc
+// from angle a0 to a1 (degrees, clockwise from the x axis).
+const char *strokes[] =
+{
+	"",
+	"3,0 3,5.5; 3,7.6 3,8",
+	"2,0 2,2.2; 4,0 4,2.2",
+	"2.2,1 1.6,7.5; 4.4,1 3.8,7.5; 0.5,3 5.5,3; 0.3,5.5 5.3,5.5",
+	"a 3,2.6 2.3,1.6 -20,-270; a 3,5.8 2.5,1.6 -90,160; 3,-0.5 3,8.5",
+	"a 1.5,1.6 1.1,1.4 0,360; a 4.5,6.4 1.1,1.4 0,360; 5.4,0.4 0.6,7.6",
+	"5.6,8 1.5,2.8 1.6,1.2 2.7,0.3 3.8,1.2 3.8,2.5 0.7,5.2 0.6,6.8 1.6,7.9 3.3,7.9 5.6,4.8",
+	"3,0 3,2.4",
+	"a 5.5,4.3 3.2,5.6 -130,-230",
+	"a 0.5,4.3 3.2,5.6 -50,50",
+	"3,0.8 3,5.2; 1,1.8 5,4.2; 5,1.8 1,4.2",
+	"3,2.2 3,7; 0.6,4.6 5.4,4.6",
+	"3.2,7.2 3.2,8.4 2.2,9.8",
+	"1,4.6 5,4.6",
+	"3,7.4 3,8",
+	"5.2,-0.3 0.8,8.8",
+	"a 3,4 2.6,4 0,360; 1.8,6 4.2,2",
+	"1.2,1.6 3.3,0 3.3,8; 1,8 5.5,8",
+	"a 3,2.5 2.5,2.5 -160,10 0.5,8 5.6,8",
+	"a 3,2 2.4,2 -160,90; a 3,6 2.7,2 -90,160",
+	"4.2,8 4.2,0 0.4,5.6 5.8,5.6",
+	"5.3,0 1,0 0.9,3.6 a 3,5.4 2.6,2.6 -135,150",
+	"4.8,0.2 3,0.3 1.6,1.3 0.6,3.2 0.4,5.5; a 3,5.5 2.6,2.5 0,360",
+	"0.5,0 5.6,0 2.2,8",
+	"a 3,2 2.3,2 0,360; a 3,6 2.7,2 0,360",
+	"a 3,2.5 2.6,2.5 0,360; 5.6,2.5 5.4,4.8 4.4,6.7 3,7.7 1.2,7.8",
+	"3,3.4 3,4; 3,7.4 3,8",
+	"3.2,3.4 3.2,4; 3.2,7.2 3.2,8.4 2.2,9.8",
+	"5.2,1.6 0.8,4.6 5.2,7.6",
+	"0.8,3.4 5.2,3.4; 0.8,5.8 5.2,5.8",
+	"0.8,1.6 5.2,4.6 0.8,7.6",
+	"a 3,2.2 2.3,2 -160,70 3,5 3,5.6; 3,7.5 3,8",
+	"a 3,4.6 1.2,1.5 0,360; 4.2,3.2 4.2,6.1 5.4,6.1 a 3,4.4 2.7,3.6 25,-290",
+	"0.2,8 3,0 5.8,8; 1.1,5.4 4.9,5.4",
+	"0.6,8 0.6,0 3.6,0 a 3.6,2 1.9,2 -90,90 0.6,4; 0.6,4 3.8,4 a 3.8,6 2,2 -90,90 0.6,8",
+	"a 3.3,4 2.9,4 -40,-320",
+	"0.6,0 0.6,8 2.6,8 a 2.6,4 3,4 90,-90 0.6,0",
+	"5.5,0 0.6,0 0.6,8 5.5,8; 0.6,4 4.8,4",
+	"5.5,0 0.6,0 0.6,8; 0.6,4 4.8,4",
+	"a 3.2,4 2.8,4 -40,-320 5.9,4.5 3.6,4.5",
+	"0.6,0 0.6,8; 5.4,0 5.4,8; 0.6,4 5.4,4",
+	"1,0 5,0; 3,0 3,8; 1,8 5,8",
+	"1.8,0 5.2,0; 4.4,0 4.4,5.6 a 2.6,5.6 1.8,2.4 0,160",
+	"0.6,0 0.6,8; 5.6,0 0.6,5.2; 2.4,3.6 5.8,8",
+	"0.8,0 0.8,8 5.6,8",
+	"0.4,8 0.6,0 3,5.2 5.4,0 5.6,8",
+	"0.6,8 0.6,0 5.4,8 5.4,0",
+	"a 3,4 2.7,4 0,360",
+	"0.6,8 0.6,0 3.4,0 a 3.4,2.3 2.2,2.3 -90,90 0.6,4.6",
+	"a 3,4 2.7,4 0,360; 3.2,6 5.8,9",
+	"0.6,8 0.6,0 3.4,0 a 3.4,2.2 2.2,2.2 -90,90 0.6,4.4; 3,4.4 5.6,8",
+	"a 3,2.05 2.5,2.05 -20,-270; a 3,6 2.7,2 -90,160",
+	"0.3,0 5.7,0; 3,0 3,8",
+	"0.6,0 0.6,5.4 a 3,5.4 2.4,2.6 180,0 5.4,0",
+	"0.2,0 3,8 5.8,0",
+	"0,0 1.4,8 3,2.6 4.6,8 6,0",
+	"0.4,0 5.6,8; 5.6,0 0.4,8",
+	"0.2,0 3,4.4 5.8,0; 3,4.4 3,8",
+	"0.6,0 5.4,0 0.6,8 5.4,8",
+	"4.6,-0.4 2,-0.4 2,8.8 4.6,8.8",
+	"0.8,-0.3 5.2,8.8",
+	"1.4,-0.4 4,-0.4 4,8.8 1.4,8.8",
+	"1,3 3,0.2 5,3",
+	"0.2,9.6 5.8,9.6",
+	"2.2,0 3.6,1.6",
+	"a 2.8,5.5 2.3,2.5 0,360; 5.1,3 5.1,8",
+	"0.8,0 0.8,8; a 3.2,5.5 2.4,2.5 0,360",
+	"a 3.2,5.5 2.5,2.5 -40,-320",
+	"5.2,0 5.2,8; a 2.8,5.5 2.4,2.5 0,360",
+	"0.7,5.5 5.6,5.5 a 3.15,5.5 2.45,2.5 0,-320",
+	"5.2,0.5 a 4,1.8 1.6,1.6 -60,-180 2.4,8; 0.8,3.2 5,3.2",
+	"a 2.8,5.3 2.3,2.3 0,360; 5.1,3 5.1,8.8 a 2.9,8.8 2.2,1.7 0,150",
+	"0.8,0 0.8,8; 0.8,5 a 3,5 2.2,2 180,360 5.2,8",
+	"1.4,3 3.2,3 3.2,8; 1,8 5.2,8; 3,0.6 3,1.3",
+	"1.4,3 4,3 4,8.6 a 2.2,8.6 1.8,1.9 0,150; 3.8,0.6 3.8,1.3",
+	"0.8,0 0.8,8; 5.2,3 0.8,6.2; 2.6,5 5.6,8",
+	"1,0 3,0 3,8; 1,8 5.2,8",
+	"0.5,8 0.5,3; 0.5,4.5 a 1.75,4.5 1.25,1.5 180,360 3,8; 3,4.5 a 4.25,4.5 1.25,1.5 180,360 5.5,8",
+	"0.8,8 0.8,3; 0.8,5 a 3,5 2.2,2 180,360 5.2,8",
+	"a 3,5.5 2.5,2.5 0,360",
+	"0.8,3 0.8,10.5; a 3.2,5.5 2.4,2.5 0,360",
+	"5.2,3 5.2,10.5; a 2.8,5.5 2.4,2.5 0,360",
+	"1,3 1,8; 1,5.4 a 3.6,5.4 2.6,2.4 180,300",
+	"a 3,4.3 2.2,1.3 -20,-270; a 3,6.8 2.4,1.2 -90,160",
+	"2.4,1 2.4,6.8 a 3.9,6.8 1.5,1.2 180,20; 0.6,3 5,3",
+	"0.8,3 0.8,6 a 3,6 2.2,2 180,0; 5.2,3 5.2,8",
+	"0.5,3 3,8 5.5,3",
+	"0.2,3 1.5,8 3,4.4 4.5,8 5.8,3",
+	"0.6,3 5.4,8; 5.4,3 0.6,8",
+	"0.5,3 3.1,8; 5.5,3 2.4,9.8 1.8,10.4 0.8,10.5",
+	"0.8,3 5.2,3 0.8,8 5.2,8",
+	"4.8,-0.4 3.7,-0.3 3.2,0.4 3.2,3.2 2.6,4 1.4,4.2 2.6,4.4 3.2,5.2 3.2,8 3.7,8.7 4.8,8.8",
+	"3,-0.6 3,9.2",
+	"1.2,-0.4 2.3,-0.3 2.8,0.4 2.8,3.2 3.4,4 4.6,4.2 3.4,4.4 2.8,5.2 2.8,8 2.3,8.7 1.2,8.8",
+	"0.6,5 1.4,4 2.4,4 3.6,5 4.6,5 5.4,4"
+};
+
+const int first_char = ' ';
+const int char_count = sizeof( strokes ) / sizeof( strokes[0] );
+
+// Accents above small letters (the x-height is 3) and capitals, and the
+// cedilla below both.
+#define GRAVE "2.2,0.4 3.8,2"
+#define ACUTE "2.2,2 3.8,0.4"
+#define CIRCUMFLEX "1.4,2 3,0.4 4.6,2"
+#define TILDE "1,1.8 2,0.8 4,1.8 5,0.8"
+#define DIAERESIS "1.6,1 1.6,1.6; 4.4,1 4.4,1.6"
+#define RING "a 3,1.2 1,0.9 0,360"
+#define CAP_GRAVE "2.2,-2.6 3.8,-1.2"
+#define CAP_ACUTE "2.2,-1.2 3.8,-2.6"
+#define CAP_CIRCUMFLEX "1.4,-1.2 3,-2.6 4.6,-1.2"
+#define CAP_TILDE "1,-1.3 2,-2.3 4,-1.3 5,-2.3"
+#define CAP_DIAERESIS "1.6,-2.2 1.6,-1.6; 4.4,-2.2 4.4,-1.6"
+#define CAP_RING "a 3,-1.6 1,0.9 0,360"
+#define CEDILLA "3,8 3.4,8.9 4,9.5 3.6,10.2 2.2,10.3"
+#define DOTLESS_I "1.4,3 3.2,3 3.2,8; 1,8 5.2,8"
+
+// Latin-1 from U+00A0 to U+00FF: the strokes of a character above (if
+// base is not 0) with more strokes added, or NULL where the font has
+// no glyph.
+struct latin1_strokes
+{
+	char base;
+	const char *more;
+};
+
+const latin1_strokes latin1_chars[] =
+{
+	{ 0, "" },
+	{ 0, "3,0 3,0.6; 3,2.5 3,8" },
+	{ 'c', "3.2,2 3.2,9" },
+	{ 0, "4.8,0.8 a 3.6,2 1.4,1.6 -30,-180 2.2,8; 0.6,8 5.4,8; 0.8,4.4 4.2,4.4" },
+	{ 0, NULL },
+	{ 'Y', "1,4.6 5,4.6; 1,6 5,6" },
+	{ 0, "3,-0.6 3,3.6; 3,5 3,9.2" },
+	{ 0, NULL },
+	{ 0, "1.6,0.4 1.6,1; 4.4,0.4 4.4,1" },
+	{ 0, NULL },
+	{ 0, NULL },
+	{ 0, "2.8,2.6 0.8,4.6 2.8,6.6; 5.2,2.6 3.2,4.6 5.2,6.6" },
+	{ 0, "0.8,3.8 5.2,3.8 5.2,5.8" },
+	{ '-', "" },
+	{ 0, NULL },
+	{ 0, "0.8,0.4 5.2,0.4" },
+	{ 0, "a 3,1.6 1.3,1.3 0,360" },
+	{ 0, "3,1.8 3,6; 0.6,3.9 5.4,3.9; 0.6,8 5.4,8" },
+	{ 0, NULL },
+	{ 0, NULL },
+	{ 0, "2.4,1.6 3.8,0" },
+	{ 0, "0.8,3 0.8,10.5; 0.8,6 a 3,6 2.2,2 180,0; 5.2,3 5.2,8" },
+	{ 0, NULL },
+	{ 0, "3,4.3 3,4.9" },
+	{ 0, CEDILLA },
+	{ 0, NULL },
+	{ 0, NULL },
+	{ 0, "0.8,2.6 2.8,4.6 0.8,6.6; 3.2,2.6 5.2,4.6 3.2,6.6" },
+	{ 0, NULL },
+	{ 0, NULL },
+	{ 0, NULL },
+	{ 0, "a 3,5.8 2.3,2 160,-70 3,3 3,2.4; 3,0.5 3,0" },
+	{ 'A', CAP_GRAVE },
+	{ 'A', CAP_ACUTE },
+	{ 'A', CAP_CIRCUMFLEX },
+	{ 'A', CAP_TILDE },
+	{ 'A', CAP_DIAERESIS },
+	{ 'A', CAP_RING },
+	{ 0, "0.2,8 3,0 5.8,0; 3,0 3,8 5.8,8; 3,4 5.2,4; 1.2,5.2 3,5.2" },
+	{ 'C', CEDILLA },
+	{ 'E', CAP_GRAVE },
+	{ 'E', CAP_ACUTE },
+	{ 'E', CAP_CIRCUMFLEX },
+	{ 'E', CAP_DIAERESIS },
+	{ 'I', CAP_GRAVE },
+	{ 'I', CAP_ACUTE },
+	{ 'I', CAP_CIRCUMFLEX },
+	{ 'I', CAP_DIAERESIS },
+	{ 'D', "0,4 2.2,4" },
+	{ 'N', CAP_TILDE },
+	{ 'O', CAP_GRAVE },
+	{ 'O', CAP_ACUTE },
+	{ 'O', CAP_CIRCUMFLEX },
+	{ 'O', CAP_TILDE },
+	{ 'O', CAP_DIAERESIS },
+	{ 0, "1.2,2.6 4.8,6.6; 4.8,2.6 1.2,6.6" },
+	{ 'O', "5.2,-0.3 0.8,8.3" },
+	{ 'U', CAP_GRAVE },
+	{ 'U', CAP_ACUTE },
+	{ 'U', CAP_CIRCUMFLEX },
+	{ 'U', CAP_DIAERESIS },
+	{ 'Y', CAP_ACUTE },
+	{ 0, "0.6,0 0.6,8; 0.6,1.8 3.4,1.8 a 3.4,3.9 2.1,2.1 -90,90 0.6,6" },
+	{ 0, "0.8,8 0.8,2 a 2.9,2 2.1,1.8 180,360 3,4 a 3,6 2.4,2 -90,90 1.8,8" },
+	{ 'a', GRAVE },
+	{ 'a', ACUTE },
+	{ 'a', CIRCUMFLEX },
+	{ 'a', TILDE },
+	{ 'a', DIAERESIS },
+	{ 'a', RING },
+	{ 0, "a 1.8,6.6 1.2,1.4 0,360; 3,3.4 3,8; 3,5.5 5.6,5.5 a 4.3,5.5 1.3,2.5 0,-320" },
+	{ 'c', CEDILLA },
+	{ 'e', GRAVE },
+	{ 'e', ACUTE },
+	{ 'e', CIRCUMFLEX },
+	{ 'e', DIAERESIS },
+	{ 0, DOTLESS_I "; " GRAVE },
+	{ 0, DOTLESS_I "; " ACUTE },
+	{ 0, DOTLESS_I "; " CIRCUMFLEX },
+	{ 0, DOTLESS_I "; " DIAERESIS },
+	{ 'o', "2,0.4 4.6,2; 3.2,0.2 5.4,3 5.5,5.5" },
+	{ 'n', TILDE },
+	{ 'o', GRAVE },
+	{ 'o', ACUTE },
+	{ 'o', CIRCUMFLEX },
+	{ 'o', TILDE },
+	{ 'o', DIAERESIS },
+	{ 0, "0.8,4.6 5.2,4.6; 3,2.2 3,2.8; 3,6.4 3,7" },
+	{ 'o', "5.2,2.4 0.8,8.6" },
+	{ 'u', GRAVE },
+	{ 'u', ACUTE },
+	{ 'u', CIRCUMFLEX },
+	{ 'u', DIAERESIS },
+	{ 'y', ACUTE },
+	{ 0, "0.8,0 0.8,10.5; a 3.2,5.5 2.4,2.5 0,360" },
+	{ 'y', DIAERESIS }
+};
+
+const int first_latin1 = 0xA0;
+const int latin1_count = sizeof( latin1_chars ) / sizeof( latin1_chars[0] );
+
+// Grid units to pixels, and the stroke half width.
+const float unit = 1.45F;
+const float origin_x = glyph_mask::left + ( glyph_mask::advance - 6 * unit ) / 2.F;
+const float origin_y = glyph_mask::center - 4 * unit;
+const float half_width = 1.05F;
+
+////////////////////////////////////////
+
+raster_point grid( float x, float y )
+{
+	raster_point p = { origin_x + x * unit, origin_y + y * unit };
+	return p;
+}
+
+////////////////////////////////////////
+
+// Reads "x,y" at s, advancing past it and any spaces.
+const char *pair( const char *s, float &x, float &y )
+{
+	char *e;
+	x = strtof( s, &e );
+	y = strtof( e + 1, &e );
+	while ( *e == ' ' )
+		++e;
+	return e;
+}
+
+////////////////////////////////////////
+
+// Round dots at the points of a polyline give it round ends and joins.
+void dots( vector<raster_point> &shapes, vector<size_t> &sizes, const vector<raster_point> &line )
+{
+	const int sides = 12;
+	for ( size_t i = 0; i < line.size(); ++i )
+	{
+		for ( int k = 0; k < sides; ++k )
+		{
+			float a = float( k ) * 2.F * float( M_PI ) / sides;
+			raster_point p = { line[i].x + half_width * cos( a ), line[i].y + half_width * sin( a ) };
+			shapes.push_back( p );
+		}
+		sizes.push_back( sides );
+	}
+}
+
+////////////////////////////////////////
+
+void outline( const char *s, vector<raster_point> &shapes, vector<size_t> &sizes )
+{
+	vector<raster_point> line;
+	while ( true )
+	{
+		while ( *s == ' ' )
+			++s;
+		if ( *s == ';' || *s == '\0' )
+		{
+			size_t before = shapes.size();
+			stroke_quads( shapes, line.data(), line.size(), half_width, false );
+			sizes.insert( sizes.end(), ( shapes.size() - before ) / 4, 4 );
+			dots( shapes, sizes, line );
+			line.clear();
+			if ( *s == '\0' )
+				break;
+			++s;
+		}
+		else if ( *s == 'a' )
+		{
+			float cx, cy, rx, ry, a0, a1;
+			s = pair( s + 1, cx, cy );
+			s = pair( s, rx, ry );
+			s = pair( s, a0, a1 );
+			int steps = int( ceil( fabs( a1 - a0 ) / 15.F ) );
+			for ( int i = 0; i <= steps; ++i )
+			{
+				float a = ( a0 + ( a1 - a0 ) * float( i ) / float( steps ) ) * float( M_PI ) / 180.F;
+				line.push_back( grid( cx + rx * cos( a ), cy + ry * sin( a ) ) );
+			}
+		}
+		else
+		{
+			float x, y;
+			s = pair( s, x, y );
+			line.push_back( grid( x, y ) );
+		}
+	}
+}
+
+////////////////////////////////////////
+
+struct mask_span
+{
+	glyph_mask *mask;
+
+	void operator()( int x, int y, int n, float c )
+	{
+		unsigned char v = (unsigned char)( c * 255.F + 0.5F );
+		memset( &mask->coverage[y][x], v, size_t( n ) );
+	}
+};
+
+////////////////////////////////////////
+
+struct font
+{
+	font( void )
+	{
+		for ( int c = 0; c < 256; ++c )
+			index[c] = '?' - first_char;
+		for ( int c = first_char; c < first_char + char_count; ++c )
+			index[c] = c - first_char;
+
+		vector<string> all( strokes, strokes + char_count );
+		for ( int i = 0; i < latin1_count; ++i )
+		{
+			const latin1_strokes &l = latin1_chars[i];
+			if ( !l.more )
+				continue;
+			string s = l.base ? strokes[l.base - first_char] : "";
+			if ( !s.empty() && *l.more )
+				s += "; ";
+			s += l.more;
+			index[first_latin1 + i] = int( all.size() );
+			all.push_back( s );
+		}
+
+		masks.resize( all.size() );
+		for ( size_t i = 0; i < all.size(); ++i )
+		{
+			vector<raster_point> shapes;
+			vector<size_t> sizes;
+			outline( all[i].c_str(), shapes, sizes );
+
+			rasterizer r( glyph_mask::width, 0, glyph_mask::height );
+			const raster_point *p = shapes.data();
+			for ( size_t k = 0; k < sizes.size(); ++k )
+			{
+				r.polygon( p, sizes[k] );
+				p += sizes[k];
+			}
+			memset( &masks[i], 0, sizeof( glyph_mask ) );
+			mask_span span = { &masks[i] };
+			r.sweep( span );
+		}
+	}
+
+	// Which mask each Latin-1 character uses.
+	int index[256];
+	vector<glyph_mask> masks;
+};
+
+}
+
+////////////////////////////////////////
+
+const glyph_mask &glyph( char c )
+{
+	static const font f;
+	return f.masks[size_t( f.index[(unsigned char)( c )] )];
+}
+
+////////////////////////////////////////
+
+string latin1( const string &utf8 )
+{
+	string ret;
+	for ( size_t i = 0; i < utf8.size(); ++i )
+	{
+		unsigned c = static_cast<unsigned char>( utf8[i] );
+		if ( c >= 0x80 )
+		{
+			int n = c >= 0xF0 ? 3 : ( c >= 0xE0 ? 2 : ( c >= 0xC0 ? 1 : 0 ) );
+			unsigned cp = c & ( 0x3Fu >> n );
+			for ( ; n > 0 && i + 1 < utf8.size() && ( utf8[i+1] & 0xC0 ) == 0x80; --n )
+				cp = ( cp << 6 ) | ( utf8[++i] & 0x3F );
+			c = n == 0 && cp >= 0xA0 && cp <= 0xFF ? cp : '?';
+		}
+		ret.push_back( char( c ) );
+	}
+	return ret;
+}
+
+////////////////////////////////////////
+
@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+////////////////////////////////////////
+
+// The built-in font of the raster backend: a monospaced bold stroke
+// font with the 12 pixel advance and 20 pixel size of the Courier used
+// by the other backends.  Each printable ASCII character, and most of
+// Latin-1, is rasterized once into a coverage mask, with the middle of
+// the capitals on the center row.
+struct glyph_mask
+{
+	enum
+	{
+		advance = 12,
+		width = 14,
+		height = 22,
+		left = 1,
+		center = 11
+	};
+
+	unsigned char coverage[height][width];
+};
+
+// c is Latin-1; characters the font has no glyph for come out as '?'.
+const glyph_mask &glyph( char c );
+
+// UTF-8 text as one Latin-1 character per code point, with '?' for
+// those past Latin-1 and for broken sequences.
+string latin1( const string &utf8 );
+
+////////////////////////////////////////
+
@@ -0,0 +1,199 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "gzip.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+const size_t max_pending = 4;
+const size_t out_size = 256 * 1024;
+
+}
+
+////////////////////////////////////////
+
+gzip_sink::gzip_sink( int fd, int level )
+	: _fd( fd ), _out( out_size ), _done( false ), _finished( false )
+{
+	memset( &_z, 0, sizeof( _z ) );
+	// 15 + 16 asks zlib for a gzip header and trailer.
+	if ( deflateInit2( &_z, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+		throw runtime_error( "could not start compression" );
+	_worker = thread( &gzip_sink::run, this );
+}
+
+////////////////////////////////////////
+
+gzip_sink::~gzip_sink( void )
+{
+	try
+	{
+		finish();
+	}
+	catch ( ... )
+	{
+	}
+	deflateEnd( &_z );
+}
+
+////////////////////////////////////////
+
+void gzip_sink::write( const char *data, size_t n )
+{
+	if ( n == 0 )
+		return;
+
+	unique_lock<mutex> lock( _lock );
+	while ( _pending.size() >= max_pending && _error.empty() )
+		_space.wait( lock );
+	// After an error the rest is dropped; finish() reports it.
+	if ( !_error.empty() )
+		return;
+
+	string chunk;
+	if ( !_spare.empty() )
+	{
+		chunk.swap( _spare.back() );
+		_spare.pop_back();
+	}
+	chunk.assign( data, n );
+	_pending.push_back( string() );
+	_pending.back().swap( chunk );
+	_ready.notify_one();
+}
+
+////////////////////////////////////////
+
+void gzip_sink::finish( void )
+{
+	if ( _finished )
+		return;
+	_finished = true;
+
+	{
+		lock_guard<mutex> lock( _lock );
+		_done = true;
+		_ready.notify_one();
+	}
+	_worker.join();
+
+	if ( !_error.empty() )
+		throw runtime_error( _error );
+}
+
+////////////////////////////////////////
+
+void gzip_sink::run( void )
+{
+	unique_lock<mutex> lock( _lock );
+	while ( true )
+	{
+		while ( _pending.empty() && !_done )
+			_ready.wait( lock );
+		if ( _pending.empty() )
+			break;
+
+		string chunk;
+		chunk.swap( _pending.front() );
+		_pending.pop_front();
+		_space.notify_one();
+
+		lock.unlock();
+		try
+		{
+			deflate_chunk( chunk.data(), chunk.size(), Z_NO_FLUSH );
+		}
+		catch ( std::exception &e )
+		{
+			lock.lock();
+			_error = e.what();
+			_pending.clear();
+			_space.notify_one();
+			return;
+		}
+		lock.lock();
+		_spare.push_back( string() );
+		_spare.back().swap( chunk );
+	}
+	lock.unlock();
+
+	try
+	{
+		deflate_chunk( NULL, 0, Z_FINISH );
+	}
+	catch ( std::exception &e )
+	{
+		lock.lock();
+		_error = e.what();
+	}
+}
+
+////////////////////////////////////////
+
+void gzip_sink::deflate_chunk( const char *data, size_t n, int mode )
+{
+	_z.next_in = reinterpret_cast<Bytef *>( const_cast<char *>( data ) );
+	_z.avail_in = uInt( n );
+	while ( true )
+	{
+		_z.next_out = reinterpret_cast<Bytef *>( &_out[0] );
+		_z.avail_out = uInt( _out.size() );
+		int ret = deflate( &_z, mode );
+		if ( ret == Z_STREAM_ERROR )
+			throw runtime_error( "compression failed" );
+		write_out( &_out[0], _out.size() - _z.avail_out );
+		if ( mode == Z_FINISH ? ret == Z_STREAM_END : _z.avail_out != 0 )
+			break;
+	}
+}
+
+////////////////////////////////////////
+
+void gzip_sink::write_out( const char *data, size_t n )
+{
+	while ( n > 0 )
+	{
+		ssize_t w = ::write( _fd, data, n );
+		if ( w < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			throw runtime_error( string( "write failed: " ) + strerror( errno ) );
+		}
+		data += w;
+		n -= size_t( w );
+	}
+}
+
+////////////////////////////////////////
+
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#include "buffer.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+// Compresses whatever a buffer flushes into it to a gzip file.  The
+// deflate runs on its own thread, so it overlaps with drawing; at most
+// a few flushed chunks are queued before write() waits for it.
+class gzip_sink : public buffer_sink
+{
+public:
+	gzip_sink( int fd, int level = Z_DEFAULT_COMPRESSION );
+	virtual ~gzip_sink( void );
+
+	virtual void write( const char *data, size_t n );
+
+	// Compress what is left and write the gzip trailer.  Throws if
+	// compressing or writing the file failed.
+	void finish( void );
+
+private:
+	gzip_sink( const gzip_sink & );
+	gzip_sink &operator=( const gzip_sink & );
+
+	void run( void );
+	void deflate_chunk( const char *data, size_t n, int mode );
+	void write_out( const char *data, size_t n );
+
+	int _fd;
+	z_stream _z;
+	vector<char> _out;
+
+	mutex _lock;
+	condition_variable _ready;
+	condition_variable _space;
+	deque<string> _pending;
+	vector<string> _spare;
+	bool _done;
+	bool _finished;
+	string _error;
+
+	thread _worker;
+};
+
+////////////////////////////////////////
+
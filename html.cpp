@@ -25,13 +25,14 @@
 
 #include "svg.h"
 #include "html.h"
+#include "escape.h"
 
 using namespace std;
 
 ////////////////////////////////////////
 
-draw_html::draw_html( ostream &o )
-	: draw_svg( o )
+draw_html::draw_html( buffer &o )
+	: draw_svg( o ), _notes( NULL )
 {
 }
 
@@ -48,8 +49,16 @@ void draw_html::begin( const string &title )
 	out <<
 		"<html>\n"
 		"<head>\n"
-		"  <title>" << escape( title ) << "</title>\n"
-		"  <meta http-equiv=\"Content-Type\" content=\"application/xhtml+xml; charset=UTF-8\"></meta>\n"
+		"  <title>";
+	xml_escape( out, title );
+	out << "</title>\n"
+		"  <meta http-equiv=\"Content-Type\" content=\"application/xhtml+xml; charset=UTF-8\"></meta>\n";
+	style();
+	out <<
+		"  <style type=\"text/css\">div.part{content-visibility:auto}";
+	if ( _notes )
+		out << "p.note{font-family:monospace;white-space:pre-wrap}";
+	out << "</style>\n"
 		"  <link type=\"text/css\" rel=\"stylesheet\" href=\"svg.css\"></link>\n"
 		"</head>\n"
 		"<body>\n";
@@ -59,6 +68,7 @@ void draw_html::begin( const string &title )
 
 void draw_html::end( void )
 {
+	close_path();
 	out << "</body>\n";
 	out << "</html>\n";
 }
@@ -67,19 +77,57 @@ void draw_html::end( void )
 
 void draw_html::id_begin( float x, float y, float w, float h, const string &name )
 {
-	out << "<div>";
-	out << "<a name=\"" << name << "\">\n";
-	draw_svg::id_begin( x, y, w, h, name );
+	close_path();
+	push_translate( point( x, y ) );
 }
 
 ////////////////////////////////////////
 
 void draw_html::id_end( void )
 {
-	draw_svg::id_end();
-	out << "</a>";
-	out << "</div>\n";
+	close_path();
+	pop_translate();
+}
+
+////////////////////////////////////////
+
+// The size is given twice: on the <svg> itself, and as the size the
+// block keeps while content-visibility skips it.
+void draw_html::part_begin( float x, float y, float w, float h, const string &name )
+{
+	close_path();
+	_part = name;
+	out << "<div class=\"part\" id=\"";
+	xml_escape( out, name );
+	out << "\" style=\"contain-intrinsic-size:" << num( w ) << "px " << num( h ) << "px\">\n"
+		"<svg overflow=\"visible\" "
+		"xmlns=\"http://www.w3.org/2000/svg\" "
+		"xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+		"width=\"" << num( w ) << "\" height=\"" << num( h ) << "\">\n";
+	push_translate( point( -xx( x ), -yy( y ) ) );
 }
 
 ////////////////////////////////////////
 
+void draw_html::part_end( void )
+{
+	close_path();
+	arrow_defs();
+	pop_translate();
+	out << "</svg>\n";
+	out << "</div>\n";
+
+	// Outside the part, which keeps its size while it is skipped.
+	if ( _notes )
+	{
+		auto note = _notes->find( _part );
+		if ( note != _notes->end() )
+		{
+			out << "<p class=\"note\">";
+			xml_escape( out, note->second );
+			out << "</p>\n";
+		}
+	}
+}
+
+////////////////////////////////////////
@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "svg.h"
@@ -33,7 +34,7 @@ using namespace std;
 class draw_html : public draw_svg
 {
 public:
-	draw_html( ostream &o );
+	draw_html( buffer &o );
 	virtual ~draw_html( void );
 
 	virtual void begin( const string &title );
@@ -41,5 +42,17 @@ public:
 
 	virtual void id_begin( float x, float y, float w, float h, const string &name );
 	virtual void id_end();
+
+	// Every part gets its own <svg>, so the browser can skip laying out
+	// and painting the ones that are off screen.
+	virtual void part_begin( float x, float y, float w, float h, const string &name );
+	virtual void part_end( void );
+
+	// Text to write under the diagram of each production, by name.
+	inline void set_notes( const unordered_map<string,string> *notes ) { _notes = notes; }
+
+private:
+	const unordered_map<string,string> *_notes;
+	string _part;
 };
 
@@ -0,0 +1,410 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+
+#include "json.h"
+#include "escape.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+draw_json::draw_json( buffer &o )
+	: draw( o ), scale( 10 ), in_list( false ), first( true ), parts( 0 ), id_w( 0 ), id_h( 0 ), pen_x( 0 ), pen_y( 0 )
+{
+	// Tenths of a pixel are finer than any screen.
+	set_precision( 1 );
+}
+
+////////////////////////////////////////
+
+draw_json::~draw_json( void )
+{
+}
+
+////////////////////////////////////////
+
+void draw_json::begin( const string &title )
+{
+	scale = 1;
+	for ( int i = std::min( std::max( precision, 0 ), 6 ); i > 0; --i )
+		scale *= 10;
+	parts = 0;
+
+	out << "{\"title\":\"";
+	json_escape( out, title );
+	out << "\",\"scale\":";
+	put( scale );
+	out << ",\"parts\":[";
+}
+
+////////////////////////////////////////
+
+void draw_json::end( void )
+{
+	list_end();
+	out << "]}\n";
+}
+
+////////////////////////////////////////
+
+void draw_json::id_begin( float x, float y, float w, float h, const string &name )
+{
+	id_w = w;
+	id_h = h;
+	push_translate( point( x, y ) );
+}
+
+////////////////////////////////////////
+
+void draw_json::id_end( void )
+{
+	list_end();
+	pop_translate();
+}
+
+////////////////////////////////////////
+
+void draw_json::link_begin( const string &name )
+{
+}
+
+////////////////////////////////////////
+
+void draw_json::link_end( void )
+{
+}
+
+////////////////////////////////////////
+
+void draw_json::part_begin( float x, float y, float w, float h, const string &name )
+{
+	list_end();
+	list_begin( w, h, name );
+	push_translate( point( -xx( x ), -yy( y ) ) );
+}
+
+////////////////////////////////////////
+
+void draw_json::part_end( void )
+{
+	list_end();
+	pop_translate();
+}
+
+////////////////////////////////////////
+
+void draw_json::circle( float x, float y, float r, Class cl )
+{
+	code( CIRCLE );
+	pen_to( xx(x), yy(y) );
+	arg( fixed( r ) );
+	arg( cl );
+}
+
+////////////////////////////////////////
+
+void draw_json::box( float x, float y, float w, float h, Class cl )
+{
+	code( BOX );
+	pen_to( xx(x), yy(y) );
+	arg( fixed( w ) );
+	arg( fixed( h ) );
+	arg( cl );
+}
+
+////////////////////////////////////////
+
+void draw_json::round( float x, float y, float w, float h, Class cl )
+{
+	code( ROUND );
+	pen_to( xx(x), yy(y) );
+	arg( fixed( w ) );
+	arg( fixed( h ) );
+	arg( cl );
+}
+
+////////////////////////////////////////
+
+void draw_json::text( float x, float y, float w, float h, const string &text, Class cl )
+{
+	code( TEXT );
+	pen_to( xx(x), yy(y + h/2.F) );
+	arg( cl );
+	arg_string( text );
+}
+
+////////////////////////////////////////
+
+void draw_json::text_center( float x, float y, float w, float h, const string &text, Class cl )
+{
+	code( TEXT_CENTER );
+	pen_to( xx(x + w/2.F), yy(y + h/2.F) );
+	arg( cl );
+	arg_string( text );
+}
+
+////////////////////////////////////////
+
+bool draw_json::reuses_groups( void ) const
+{
+	return true;
+}
+
+////////////////////////////////////////
+
+bool draw_json::group_begin( const string &key, float x, float y )
+{
+	unordered_map<string,int>::const_iterator i = groups.find( key );
+	if ( i != groups.end() )
+	{
+		code( USE );
+		arg( i->second );
+		pen_to( xx(x), yy(y) );
+		return true;
+	}
+
+	int n = int( groups.size() );
+	groups[key] = n;
+	code( GROUP );
+	pen_to( xx(x), yy(y) );
+	origins.push_back( pen_x );
+	origins.push_back( pen_y );
+	return false;
+}
+
+////////////////////////////////////////
+
+void draw_json::group_end( void )
+{
+	code( GROUP_END );
+	pen_y = origins.back();
+	origins.pop_back();
+	pen_x = origins.back();
+	origins.pop_back();
+}
+
+////////////////////////////////////////
+
+void draw_json::path_begin( float x, float y, Class cl )
+{
+	code( PATH );
+	arg( cl );
+	pen_to( xx(x), yy(y) );
+}
+
+////////////////////////////////////////
+
+void draw_json::path_move( float x, float y )
+{
+	code( MOVE );
+	pen_to( xx(x), yy(y) );
+}
+
+////////////////////////////////////////
+
+void draw_json::path_h_by( float x )
+{
+	code( H_LINE );
+	long dx = fixed( x );
+	arg( dx );
+	pen_x += dx;
+}
+
+////////////////////////////////////////
+
+void draw_json::path_v_by( float y )
+{
+	code( V_LINE );
+	long dy = fixed( y );
+	arg( dy );
+	pen_y += dy;
+}
+
+////////////////////////////////////////
+
+void draw_json::path_h_to( float x )
+{
+	code( H_LINE );
+	long px = fixed( xx(x) );
+	arg( px - pen_x );
+	pen_x = px;
+}
+
+////////////////////////////////////////
+
+void draw_json::path_v_to( float y )
+{
+	code( V_LINE );
+	long py = fixed( yy(y) );
+	arg( py - pen_y );
+	pen_y = py;
+}
+
+////////////////////////////////////////
+
+void draw_json::path_to( float x, float y )
+{
+	code( LINE );
+	pen_to( xx(x), yy(y) );
+}
+
+////////////////////////////////////////
+
+// The arc ends r away in both directions, as in draw_svg::path_arc().
+void draw_json::path_arc( float r, Arc a )
+{
+	code( ARC );
+	long fr = fixed( r );
+	arg( fr );
+	arg( a );
+	switch ( a )
+	{
+		case RIGHT_UP: case UP_RIGHT: pen_x += fr; pen_y -= fr; break;
+		case RIGHT_DOWN: case DOWN_RIGHT: pen_x += fr; pen_y += fr; break;
+		case LEFT_UP: case UP_LEFT: pen_x -= fr; pen_y -= fr; break;
+		case LEFT_DOWN: case DOWN_LEFT: pen_x -= fr; pen_y += fr; break;
+	}
+}
+
+////////////////////////////////////////
+
+void draw_json::path_arrow_left( float size )
+{
+	code( ARROW_LEFT );
+	arg( fixed( size ) );
+}
+
+////////////////////////////////////////
+
+void draw_json::path_arrow_right( float size )
+{
+	code( ARROW_RIGHT );
+	arg( fixed( size ) );
+}
+
+////////////////////////////////////////
+
+void draw_json::path_arrow_down( float size )
+{
+	code( ARROW_DOWN );
+	arg( fixed( size ) );
+}
+
+////////////////////////////////////////
+
+void draw_json::path_end( void )
+{
+	code( PATH_END );
+}
+
+////////////////////////////////////////
+
+void draw_json::list_begin( float w, float h, const string &name )
+{
+	out << ( parts++ > 0 ? ",\n{\"name\":\"" : "\n{\"name\":\"" );
+	json_escape( out, name );
+	out << "\",\"w\":";
+	put( fixed( w ) );
+	out << ",\"h\":";
+	put( fixed( h ) );
+	out << ",\"d\":[";
+	in_list = true;
+	first = true;
+	pen_x = pen_y = 0;
+}
+
+////////////////////////////////////////
+
+void draw_json::list_end( void )
+{
+	close_path();
+	if ( in_list )
+	{
+		out << "]}";
+		in_list = false;
+	}
+}
+
+////////////////////////////////////////
+
+// Everything but the path codes ends an open path first.  Anything
+// drawn outside of a part goes into one the size of the whole.
+void draw_json::code( Code c )
+{
+	if ( c > PATH_END )
+		close_path();
+	if ( !in_list )
+		list_begin( id_w, id_h, string() );
+	if ( !first )
+		out << ',';
+	first = false;
+	put( c );
+}
+
+////////////////////////////////////////
+
+void draw_json::arg( long v )
+{
+	out << ',';
+	put( v );
+}
+
+////////////////////////////////////////
+
+void draw_json::put( long v )
+{
+	char buf[24];
+	char *e = buf + sizeof( buf ), *p = e;
+	unsigned long u = v < 0 ? 0UL - static_cast<unsigned long>( v ) : static_cast<unsigned long>( v );
+	do
+	{
+		*--p = char( '0' + u % 10 );
+		u /= 10;
+	} while ( u > 0 );
+	if ( v < 0 )
+		*--p = '-';
+	out.append( p, size_t( e - p ) );
+}
+
+////////////////////////////////////////
+
+void draw_json::arg_string( const string &s )
+{
+	out << ",\"";
+	json_escape( out, s );
+	out << '"';
+}
+
+////////////////////////////////////////
+
+void draw_json::pen_to( float x, float y )
+{
+	long px = fixed( x ), py = fixed( y );
+	arg( px - pen_x );
+	arg( py - pen_y );
+	pen_x = px;
+	pen_y = py;
+}
+
+////////////////////////////////////////
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "draw.h"
+
+using namespace std;
+
+// Writes the draw calls as a JSON display list, for canvas.js to draw
+// in a browser.  The document is
+//
+//   {"title":"...","scale":10,"parts":[{"name":"...","w":W,"h":H,"d":[...]},...]}
+//
+// with one part for the title and each production.  All numbers are
+// integers in 1/scale pixels, and every position is relative to the
+// previous one (the pen), which starts at the top left of each part.
+// The list in "d" is a flat array of codes, each followed by its
+// arguments:
+//
+//   0 class dx dy      begin a path            9                 end the path
+//   1 dx dy            move (a new subpath)    10 dx dy w h class box
+//   2 dx               horizontal line         11 dx dy r class   circle
+//   3 dy               vertical line           12 dx dy w h class rounded box
+//   4 dx dy            line                    13 dx dy class "s" text, left aligned
+//   5 r arc            quarter circle          14 dx dy class "s" text, centered
+//   6 size             arrowhead, left         15 dx dy           begin a group
+//   7 size             arrowhead, right        16                 end the group
+//   8 size             arrowhead, down         17 n dx dy         draw group n again
+//
+// Text is positioned by the middle of its left edge or of its center.
+// Groups are numbered from 0 in the order they begin in the document,
+// and may be drawn again in any later part.  The pen is back at the
+// group's origin after one.
+class draw_json : public draw
+{
+public:
+	draw_json( buffer &o );
+	virtual ~draw_json( void );
+
+	virtual void begin( const string &title );
+	virtual void end( void );
+
+	virtual void id_begin( float x, float y, float w, float h, const string &name );
+	virtual void id_end();
+
+	virtual void link_begin( const string &name ) final;
+	virtual void link_end() final;
+
+	virtual void part_begin( float x, float y, float w, float h, const string &name );
+	virtual void part_end( void );
+
+	virtual void circle( float x, float y, float r, Class cl ) final;
+	virtual void box( float x, float y, float w, float h, Class cl ) final;
+	virtual void round( float x, float y, float w, float h, Class c ) final;
+	virtual void text( float x, float y, float w, float h, const string &text, Class cl ) final;
+	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl ) final;
+
+	virtual bool reuses_groups( void ) const;
+	virtual bool group_begin( const string &key, float x, float y );
+	virtual void group_end( void );
+
+	virtual void path_begin( float x, float y, Class cl ) final;
+	virtual void path_move( float x, float y ) final;
+
+	virtual void path_h_by( float x ) final;
+	virtual void path_v_by( float y ) final;
+	virtual void path_h_to( float x ) final;
+	virtual void path_v_to( float y ) final;
+	virtual void path_to( float x, float y ) final;
+	virtual void path_arc( float r, Arc a ) final;
+	virtual void path_arrow_left( float size ) final;
+	virtual void path_arrow_right( float size ) final;
+	virtual void path_arrow_down( float size ) final;
+
+	virtual void path_end( void ) final;
+
+private:
+	enum Code
+	{
+		PATH, MOVE, H_LINE, V_LINE, LINE, ARC, ARROW_LEFT, ARROW_RIGHT, ARROW_DOWN, PATH_END,
+		BOX, CIRCLE, ROUND, TEXT, TEXT_CENTER, GROUP, GROUP_END, USE
+	};
+
+	inline long fixed( float v ) const { return lround( v * scale ); }
+
+	void list_begin( float w, float h, const string &name );
+	void list_end( void );
+	void code( Code c );
+	void arg( long v );
+	void put( long v );
+	void arg_string( const string &s );
+	void pen_to( float x, float y );
+
+	long scale;
+	bool in_list;
+	bool first;
+	int parts;
+	float id_w, id_h;
+
+	// The pen, in 1/scale pixels.
+	long pen_x, pen_y;
+
+	// Groups by key, and the origins of those being drawn.
+	unordered_map<string,int> groups;
+	vector<long> origins;
+};
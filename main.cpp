@@ -4,20 +4,52 @@
 #include <fstream>
 #include <string>
 #include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "node.h"
 #include "print.h"
 #include "svg.h"
 #include "tikz.h"
 #include "html.h"
+#include "png.h"
+#include "pdf.h"
+#include "json.h"
 #include "render.h"
+#include "record.h"
+#include "gzip.h"
+#include "split.h"
+#include "tiles.h"
+#include "spatial.h"
+#include "xref.h"
+#include "reach.h"
+#include "simplify.h"
+#include "analysis.h"
 #include <dparse.h>
 
 using namespace std;
 
 extern D_ParserTables parser_tables_gram;
 
+// Where parser diagnostics go; batch workers collect them per file.
+static __thread ostream *diag = NULL;
+
+inline ostream &errors( void )
+{
+	return diag ? *diag : cerr;
+}
+
 ////////////////////////////////////////
 
 void
@@ -42,7 +74,7 @@ syntax( struct D_Parser *parser )
 		indent.replace( col, 1, "\033[1;31m⬇\033[0;39m" );
 		indent2.replace( col, 1, "\033[1;31m⬆\033[0;39m" );
 	}
-	cerr << "Error at line " << lnum << "  col " << col << ":\n" << indent << '\n' << text << '\n' << indent2 << "\n\n";
+	errors() << "Error at line " << lnum << "  col " << col << ":\n" << indent << '\n' << text << '\n' << indent2 << "\n\n";
 	parser->error_recovery = 0;
 }
 
@@ -51,10 +83,10 @@ syntax( struct D_Parser *parser )
 struct D_ParseNode *
 ambiguous( struct D_Parser *parser, int n, struct D_ParseNode **v )
 {
-	cerr << "Ambiguous!!!\n";
+	errors() << "Ambiguous!!!\n";
 	for ( int i = 0; i < n; ++i )
-		cerr << "Parse " << i << ' ' << v[i]->user << ":\n" << *(v[i]->user);
-	cerr << endl;
+		errors() << "Parse " << i << ' ' << v[i]->user << ":\n" << *(v[i]->user);
+	errors() << endl;
 	return NULL;
 }
 
@@ -88,7 +120,7 @@ parse( istream &in )
 	}
 	else if ( !p->syntax_errors )
 	{
-		cerr << "Unknown error! " << (void *)parsed << endl;
+		errors() << "Unknown error! " << (void *)parsed << endl;
 		if ( parsed )
 			free_D_ParseNode( p, parsed );
 	}
@@ -98,6 +130,23 @@ parse( istream &in )
 	return ret;
 }
 
+////////////////////////////////////////
+
+node *
+parse_file( const string &filename )
+{
+	ifstream inp( filename.c_str() );
+	if ( !inp )
+		throw runtime_error( "could not open " + filename );
+
+	node *ret = parse( inp );
+	if ( ret == NULL )
+		throw runtime_error( "could not parse " + filename );
+	return ret;
+}
+
+////////////////////////////////////////
+
 bool ends_with( const char *str, const char *suffix )
 {
 	if ( !str || !suffix )
@@ -114,38 +163,633 @@ bool ends_with( const char *str, const char *suffix )
 
 ////////////////////////////////////////
 
-int main( int argc, char *argv[] )
+bool compressed_output( const char *filename )
+{
+	return ends_with( filename, ".svgz" ) || ends_with( filename, ".html.gz" );
+}
+
+////////////////////////////////////////
+
+bool known_output( const char *filename )
+{
+	return ends_with( filename, ".html" ) || ends_with( filename, ".svg" ) || ends_with( filename, ".tex" ) || ends_with( filename, ".png" ) || ends_with( filename, ".pdf" ) || ends_with( filename, ".json" ) || compressed_output( filename );
+}
+
+////////////////////////////////////////
+
+struct options
+{
+	options( void )
+		: batch( NULL ), outdir( NULL ), split( NULL ), tiles( NULL ), xref( NULL ), root( NULL ), tile_size( 1024 ), jobs( 0 ), minify( false ), query( false ), unreachable( false ), simplify( false ), check( false ), precision( -1 )
+	{
+	}
+
+	const char *batch;
+	const char *outdir;
+	const char *split;
+	const char *tiles;
+	const char *xref;
+	const char *root;
+	int tile_size;
+	unsigned jobs;
+	bool minify;
+	bool query;
+	bool unreachable;
+	bool simplify;
+	bool check;
+	int precision;
+	vector<const char *> args;
+
+	// The notes of --check for HTML output, filled in by load_grammar().
+	shared_ptr<unordered_map<string,string>> notes;
+};
+
+////////////////////////////////////////
+
+draw *backend( const char *filename, buffer &out, const options &opts )
+{
+	draw *dc = NULL;
+	bool html = ends_with( filename, ".html" ) || ends_with( filename, ".html.gz" );
+	if ( html || ends_with( filename, ".svg" ) || ends_with( filename, ".svgz" ) )
+	{
+		draw_svg *svg = html ? new draw_html( out ) : new draw_svg( out );
+		svg->set_minify( opts.minify );
+		if ( html && opts.notes )
+			static_cast<draw_html *>( svg )->set_notes( opts.notes.get() );
+		dc = svg;
+	}
+	else if ( ends_with( filename, ".tex" ) )
+		dc = new draw_tikz( out );
+	else if ( ends_with( filename, ".png" ) )
+		dc = new draw_png( out );
+	else if ( ends_with( filename, ".pdf" ) )
+		dc = new draw_pdf( out );
+	else if ( ends_with( filename, ".json" ) )
+		dc = new draw_json( out );
+
+	if ( dc && opts.precision >= 0 )
+		dc->set_precision( opts.precision );
+	return dc;
+}
+
+////////////////////////////////////////
+
+// Render (or replay, when list is given) into a single output file.
+// Compressed outputs go through a gzip_sink instead of straight to the
+// file.
+void write_output( const options &opts, const string &filename, const node *gram, const buffer *list, buffer &out )
 {
+	int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+	if ( fd < 0 )
+		throw runtime_error( "could not open " + filename + ": " + strerror( errno ) );
+
+	unique_ptr<gzip_sink> gz;
 	try
 	{
-		if ( argc < 3 || argc > 3 )
+		if ( compressed_output( filename.c_str() ) )
+		{
+			gz.reset( new gzip_sink( fd ) );
+			out.attach( gz.get() );
+		}
+		else
+			out.attach( fd );
+		unique_ptr<draw> dc( backend( filename.c_str(), out, opts ) );
+		if ( list )
+			replay( *dc, *list );
+		else if ( draw_svg *svg = dynamic_cast<draw_svg *>( dc.get() ) )
+			render( *svg, gram );
+		else if ( draw_tikz *tikz = dynamic_cast<draw_tikz *>( dc.get() ) )
+			render( *tikz, gram );
+		else
+			render( *dc, gram );
+		out.attach( -1 );
+		if ( gz )
+			gz->finish();
+	}
+	catch ( ... )
+	{
+		out.clear();
+		out.attach( -1 );
+		gz.reset();
+		close( fd );
+		throw;
+	}
+	close( fd );
+}
+
+////////////////////////////////////////
+
+// Write every output of one grammar.  With more than one output the
+// layout is recorded once into list and replayed for each.
+void write_outputs( const options &opts, const node *gram, const vector<string> &outputs, buffer &list, buffer &out )
+{
+	if ( outputs.size() == 1 )
+	{
+		write_output( opts, outputs[0], gram, NULL, out );
+		return;
+	}
+
+	list.clear();
+	{
+		draw_record rec( list );
+		render( rec, gram );
+	}
+	for ( size_t i = 0; i < outputs.size(); ++i )
+		write_output( opts, outputs[i], gram, &list, out );
+}
+
+////////////////////////////////////////
+
+void usage( const char *prog )
+{
+	cerr << "Usage:\n"
+		"\t" << prog << " [options] <grammar_file> <output.svg|output.html|output.tex|output.png|output.pdf|output.json|output.svgz|output.html.gz> ...\n"
+		"\t" << prog << " [options] [-j <jobs>] [-o <dir>] --batch <dir|manifest|-> <svg|html|tex|png|pdf|json|svgz|html.gz> ...\n"
+		"\t" << prog << " [options] --split <dir> <grammar_file> <svg|html|tex> ...\n"
+		"\t" << prog << " [options] [--tile-size <n>] --tiles <dir> <grammar_file> <svg|png> ...\n"
+		"\t" << prog << " --query <grammar_file>\n"
+		"\n"
+		"--root <name> only draws the productions that <name> leads to, starting\n"
+		"with it, and --unreachable lists the others on stdout.\n"
+		"\n"
+		"--simplify flattens nested choices and sequences, merges nested [ ], { }\n"
+		"and < >, and factors out the common start of neighbouring alternatives.\n"
+		"\n"
+		"--check reports LL(1) conflicts and left recursion, and notes the nullable,\n"
+		"FIRST and FOLLOW sets of every production under it in HTML output.\n"
+		"\n"
+		"--xref <file> also writes where every nonterminal is defined and used to a\n"
+		"JSON file, and reports the ones used but never defined.\n"
+		"\n"
+		"--minify writes smaller SVG and HTML (relative paths, fewer attributes).\n"
+		"--precision <n> sets the number of decimals in coordinates (default 3, 2 in em for .tex, 2 for .pdf, 1 for .json).\n"
+		"\n"
+		"--batch renders every grammar listed in a manifest (one path per line),\n"
+		"every .ebnf file in a directory, or NUL separated paths read from stdin (-).\n"
+		"Outputs are written next to each grammar, or into <dir> with -o.\n"
+		"\n"
+		"--split writes every production to a file of its own in <dir>, plus an\n"
+		"index.  Files that did not change are not rewritten.\n"
+		"\n"
+		"--tiles cuts the drawing into <n> pixel square tiles (default 1024) in\n"
+		"<dir>, named row_col, plus a tiles.<ext>.json manifest of the ones not empty.\n"
+		"\n"
+		"--query lays the grammar out and reads \"x y\" or \"x y w h\" lines from stdin,\n"
+		"answering each with the nodes at that point (innermost first) or in that\n"
+		"rectangle: kind, symbol, production and box, then an empty line.\n";
+}
+
+////////////////////////////////////////
+
+bool parse_options( int argc, char *argv[], options &opts )
+{
+	for ( int i = 1; i < argc; ++i )
+	{
+		string arg( argv[i] );
+		if ( arg == "--minify" )
+			opts.minify = true;
+		else if ( arg == "--query" )
+			opts.query = true;
+		else if ( arg == "--unreachable" )
+			opts.unreachable = true;
+		else if ( arg == "--simplify" )
+			opts.simplify = true;
+		else if ( arg == "--check" )
+		{
+			opts.check = true;
+			opts.notes = make_shared<unordered_map<string,string>>();
+		}
+		else if ( arg == "--batch" || arg == "--split" || arg == "--tiles" || arg == "--tile-size" || arg == "--xref" || arg == "--root" || arg == "-o" || arg == "-j" || arg == "--precision" )
+		{
+			if ( i + 1 >= argc )
+				return false;
+			const char *value = argv[++i];
+			if ( arg == "--batch" )
+				opts.batch = value;
+			else if ( arg == "--split" )
+				opts.split = value;
+			else if ( arg == "--tiles" )
+				opts.tiles = value;
+			else if ( arg == "--tile-size" )
+				opts.tile_size = atoi( value );
+			else if ( arg == "--xref" )
+				opts.xref = value;
+			else if ( arg == "--root" )
+				opts.root = value;
+			else if ( arg == "-o" )
+				opts.outdir = value;
+			else if ( arg == "--precision" )
+				opts.precision = atoi( value );
+			else
+				opts.jobs = unsigned( atoi( value ) );
+		}
+		else if ( arg.size() > 1 && arg[0] == '-' )
+			return false;
+		else
+			opts.args.push_back( argv[i] );
+	}
+
+	if ( opts.batch )
+		return !opts.args.empty() && !opts.xref && !opts.root && !opts.check;
+	if ( opts.unreachable && !opts.root )
+		return false;
+	if ( opts.query )
+		return opts.args.size() == 1;
+	return opts.args.size() >= 2;
+}
+
+////////////////////////////////////////
+
+vector<string> batch_inputs( const char *source )
+{
+	vector<string> ret;
+	string line;
+
+	struct stat st;
+	if ( strcmp( source, "-" ) == 0 )
+	{
+		while ( getline( cin, line, '\0' ) )
+		{
+			if ( !line.empty() )
+				ret.push_back( line );
+		}
+	}
+	else if ( stat( source, &st ) == 0 && S_ISDIR( st.st_mode ) )
+	{
+		DIR *dir = opendir( source );
+		if ( dir == NULL )
+			throw runtime_error( string( "could not read directory " ) + source );
+		while ( struct dirent *ent = readdir( dir ) )
+		{
+			if ( ends_with( ent->d_name, ".ebnf" ) )
+				ret.push_back( string( source ) + '/' + ent->d_name );
+		}
+		closedir( dir );
+		sort( ret.begin(), ret.end() );
+	}
+	else
+	{
+		ifstream manifest( source );
+		if ( !manifest )
+			throw runtime_error( string( "could not open manifest " ) + source );
+		while ( getline( manifest, line ) )
+		{
+			if ( !line.empty() && line[0] != '#' )
+				ret.push_back( line );
+		}
+	}
+
+	return ret;
+}
+
+////////////////////////////////////////
+
+string output_name( const string &input, const string &ext, const char *outdir )
+{
+	size_t slash = input.rfind( '/' );
+	size_t dot = input.rfind( '.' );
+	if ( dot != string::npos && slash != string::npos && dot < slash )
+		dot = string::npos;
+
+	string ret;
+	if ( outdir )
+	{
+		ret = string( outdir ) + '/';
+		ret += input.substr( slash == string::npos ? 0 : slash + 1 );
+		if ( dot != string::npos )
+			ret.erase( ret.size() - ( input.size() - dot ) );
+	}
+	else
+		ret = input.substr( 0, dot );
+
+	return ret + '.' + ext;
+}
+
+////////////////////////////////////////
+
+// The cross-reference index of a grammar, as a JSON file.  Nonterminals
+// that are used but never defined are reported.
+void write_xref( const char *filename, const node *gram )
+{
+	xref refs( gram );
+	const symbol_table &syms = refs.symbols();
+	vector<int> undef = refs.undefined();
+	for ( size_t i = 0; i < undef.size(); ++i )
+	{
+		cerr << "Undefined nonterminal " << syms.name( undef[i] ) << " used in";
+		const vector<int> &at = refs.used_at( undef[i] );
+		for ( size_t j = 0; j < at.size(); ++j )
+			cerr << ' ' << syms.name( refs.defines( size_t( at[j] ) ) );
+		cerr << '\n';
+	}
+
+	buffer out;
+	refs.write_json( out );
+	write_if_changed( filename, out );
+}
+
+////////////////////////////////////////
+
+// The grammar named on the command line, cut down to what --root leads
+// to and simplified for --simplify, with its cross-reference index
+// written for --xref and its analysis reported for --check.
+node *load_grammar( const options &opts )
+{
+	node *gram = parse_file( opts.args[0] );
+	if ( opts.root )
+	{
+		reach_result r = reachable( gram, opts.root );
+		gram = r.gram;
+		cerr << "Root " << opts.root << " of " << opts.args[0] << ": " << grammar_productions( gram ).size() << " productions reached, " << r.unreachable.size() << " left out, " << r.cycles << " recursive groups" << endl;
+		if ( opts.unreachable )
+		{
+			for ( size_t i = 0; i < r.unreachable.size(); ++i )
+			{
+				const literal *id = dynamic_cast<const literal*>( r.unreachable[i]->id() );
+				cout << ( id ? id->value() : string() ) << '\n';
+			}
+			cout << flush;
+		}
+	}
+	if ( opts.simplify )
+	{
+		simplify_result s = simplify( gram );
+		gram = s.gram;
+		cerr << "Simplified " << opts.args[0] << ": removed " << s.before - s.after << " of " << s.before << " nodes" << endl;
+	}
+	if ( opts.xref )
+		write_xref( opts.xref, gram );
+	if ( opts.check )
+	{
+		grammar_analysis a( gram );
+		a.report( cerr );
+		size_t left = 0;
+		for ( const vector<size_t> &group: a.left_recursion() )
+			left += group.size();
+		cerr << "Checked " << opts.args[0] << ": " << a.prod_count() << " productions, " << a.terminal_count() - 1 << " terminals, " << a.conflicts().size() << " LL(1) conflicts, " << left << " left recursive productions" << endl;
+		a.notes( *opts.notes );
+	}
+	return gram;
+}
+
+////////////////////////////////////////
+
+// Render many grammars on a pool of worker threads.  Every worker
+// keeps its own node arena and buffers and reuses them from one file
+// to the next.  A failing grammar is reported and skipped.
+int batch( const options &opts )
+{
+	vector<string> exts;
+	for ( size_t i = 0; i < opts.args.size(); ++i )
+	{
+		string ext( opts.args[i] );
+		if ( !ext.empty() && ext[0] == '.' )
+			ext.erase( 0, 1 );
+		if ( !known_output( ( "." + ext ).c_str() ) )
+		{
+			cerr << "Output type should be svg, html, tex, png, pdf, json, svgz, or html.gz: " << opts.args[i] << endl;
+			return -1;
+		}
+		exts.push_back( ext );
+	}
+
+	vector<string> inputs = batch_inputs( opts.batch );
+
+	unsigned jobs = opts.jobs;
+	if ( jobs == 0 )
+		jobs = std::max( 1U, thread::hardware_concurrency() );
+	jobs = unsigned( std::min( size_t( jobs ), std::max( size_t( 1 ), inputs.size() ) ) );
+
+	atomic<size_t> next( 0 );
+	atomic<size_t> failed( 0 );
+	mutex report;
+
+	auto work = [&]( void )
+	{
+		node_arena arena;
+		buffer list;
+		buffer out;
+		vector<string> outputs;
+
+		for ( size_t i = next++; i < inputs.size(); i = next++ )
+		{
+			const string &input = inputs[i];
+			ostringstream log;
+			diag = &log;
+			try
+			{
+				outputs.clear();
+				for ( size_t e = 0; e < exts.size(); ++e )
+					outputs.push_back( output_name( input, exts[e], opts.outdir ) );
+				node *gram = parse_file( input );
+				if ( opts.simplify )
+					gram = simplify( gram ).gram;
+				write_outputs( opts, gram, outputs, list, out );
+			}
+			catch ( std::exception &e )
+			{
+				log << "ERROR: " << e.what() << '\n';
+				++failed;
+			}
+			diag = NULL;
+			arena.clear();
+
+			if ( !log.str().empty() )
+			{
+				lock_guard<mutex> lock( report );
+				cerr << input << ":\n" << log.str() << flush;
+			}
+		}
+	};
+
+	vector<thread> workers;
+	for ( unsigned i = 1; i < jobs; ++i )
+		workers.push_back( thread( work ) );
+	work();
+	for ( size_t i = 0; i < workers.size(); ++i )
+		workers[i].join();
+
+	if ( failed > 0 )
+	{
+		cerr << failed << " of " << inputs.size() << " grammars failed" << endl;
+		return -1;
+	}
+	return 0;
+}
+
+////////////////////////////////////////
+
+// Split output into a directory, once per extension.
+int split( const options &opts )
+{
+	for ( size_t i = 1; i < opts.args.size(); ++i )
+	{
+		string ext( opts.args[i] );
+		if ( ext != "svg" && ext != "html" && ext != "tex" )
+		{
+			cerr << "Split output type should be svg, html, or tex: " << ext << endl;
+			return -1;
+		}
+	}
+
+	node *gram = load_grammar( opts );
+	for ( size_t i = 1; i < opts.args.size(); ++i )
+	{
+		string ext( opts.args[i] );
+		split_result r = write_split( gram, opts.split, ext, [&]( buffer &out )
 		{
-			cerr << "Usage:\n\t" << argv[0] << " <grammar_file> [ <output.svg> | <output.html> | <output.tex> ]" << endl;
+			return backend( ( "." + ext ).c_str(), out, opts );
+		} );
+		cerr << "Split " << ext << " into " << opts.split << ": " << r.written << " written, " << r.unchanged << " unchanged" << endl;
+	}
+	return 0;
+}
+
+////////////////////////////////////////
+
+// Tiled output into a directory, once per extension.
+int tiles( const options &opts )
+{
+	for ( size_t i = 1; i < opts.args.size(); ++i )
+	{
+		string ext( opts.args[i] );
+		if ( ext != "svg" && ext != "png" )
+		{
+			cerr << "Tiled output type should be svg or png: " << ext << endl;
 			return -1;
 		}
+	}
+	if ( opts.tile_size <= 0 )
+	{
+		cerr << "Tile size should be positive: " << opts.tile_size << endl;
+		return -1;
+	}
+
+	node *gram = load_grammar( opts );
+	for ( size_t i = 1; i < opts.args.size(); ++i )
+	{
+		string ext( opts.args[i] );
+		write_tiles( gram, opts.tiles, ext, opts.tile_size, [&]( buffer &out )
+		{
+			return backend( ( "." + ext ).c_str(), out, opts );
+		} );
+	}
+	return 0;
+}
 
-		ifstream inp( argv[1] );
-		ofstream out( argv[2] );
+////////////////////////////////////////
+
+// Hit tests against the layout of a grammar, one per line of stdin.
+int query( const options &opts )
+{
+	node *gram = load_grammar( opts );
+	render_context ctxt;
+	layout( ctxt, gram );
+	spatial_index index( ctxt, gram );
+
+	vector<const hit *> hits;
+	string line;
+	while ( getline( cin, line ) )
+	{
+		istringstream in( line );
+		float x, y, w, h;
+		if ( !( in >> x >> y ) )
+		{
+			cout << "ERROR: expected x y [w h]\n" << endl;
+			continue;
+		}
+		if ( in >> w >> h )
+			index.in( x, y, w, h, hits );
+		else
+			index.at( x, y, hits );
 
-		draw *dc = NULL;
+		for ( const hit *n: hits )
+			cout << kind_name( n->kind ) << '\t' << *n->symbol << '\t' << *n->production << '\t' << n->x << ' ' << n->y << ' ' << n->w << ' ' << n->h << '\n';
+		cout << endl;
+	}
+	return 0;
+}
 
-		if ( ends_with( argv[2], ".html" ) )
-			dc = new draw_html( out );
-		else if ( ends_with( argv[2], ".svg" ) )
-			dc = new draw_svg( out );
-		else if ( ends_with( argv[2], ".tex" ) )
-			dc = new draw_tikz( out );
+////////////////////////////////////////
 
-		if ( dc == NULL )
+int main( int argc, char *argv[] )
+{
+	try
+	{
+		options opts;
+		if ( !parse_options( argc, argv, opts ) )
 		{
-			cerr << "Output file should end in .svg, .html, or .tex" << endl;
+			usage( argv[0] );
 			return -1;
 		}
 
-		node *node = parse( inp );
-		render( *dc, node );
+		if ( opts.batch )
+			return batch( opts );
+		if ( opts.split )
+			return split( opts );
+		if ( opts.tiles )
+			return tiles( opts );
+		if ( opts.query )
+			return query( opts );
+
+		for ( size_t i = 1; i < opts.args.size(); ++i )
+		{
+			if ( !known_output( opts.args[i] ) )
+			{
+				cerr << "Output file should end in .svg, .html, .tex, .png, .pdf, .json, .svgz, or .html.gz: " << opts.args[i] << endl;
+				return -1;
+			}
+		}
+
+		node *node = load_grammar( opts );
+
+		if ( opts.args.size() == 2 )
+		{
+			buffer out;
+			write_output( opts, opts.args[1], node, NULL, out );
+			return 0;
+		}
+
+		// Several outputs: lay out once into a display list, then
+		// replay it into every backend in parallel.
+		buffer list;
+		{
+			draw_record rec( list );
+			render( rec, node );
+		}
 
-		return 0;
+		vector<string> errors( opts.args.size() - 1 );
+		vector<thread> workers;
+		for ( size_t i = 1; i < opts.args.size(); ++i )
+		{
+			const char *filename = opts.args[i];
+			string *error = &errors[i - 1];
+			workers.push_back( thread( [filename, error, &list, &opts]( void )
+			{
+				try
+				{
+					buffer out;
+					write_output( opts, filename, NULL, &list, out );
+				}
+				catch ( std::exception &e )
+				{
+					*error = e.what();
+				}
+			} ) );
+		}
+
+		int ret = 0;
+		for ( size_t i = 0; i < workers.size(); ++i )
+		{
+			workers[i].join();
+			if ( !errors[i].empty() )
+			{
+				cerr << "ERROR: " << opts.args[i + 1] << ": " << errors[i] << endl;
+				ret = -1;
+			}
+		}
+
+		return ret;
 	}
 	catch ( std::exception &e )
 	{
@@ -154,5 +798,3 @@ int main( int argc, char *argv[] )
 
 	return -1;
 }
-
-
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -33,9 +34,43 @@ class node;
 
 ////////////////////////////////////////
 
+// Collects every node created on this thread while it is alive, and
+// deletes them all on clear() or destruction.  Without an arena, nodes
+// are never freed (fine for a single run, not for batch mode).
+class node_arena
+{
+public:
+	node_arena( void );
+	~node_arena( void );
+
+	void clear( void );
+
+	inline void add( node *n ) { _nodes.push_back( n ); }
+	inline size_t size( void ) const { return _nodes.size(); }
+
+	static inline node_arena *current( void ) { return _current; }
+
+private:
+	node_arena( const node_arena & );
+	node_arena &operator=( const node_arena & );
+
+	vector<node *> _nodes;
+	node_arena *_previous;
+
+	static __thread node_arena *_current;
+};
+
+////////////////////////////////////////
+
 class node
 {
 public:
+	node( void )
+	{
+		if ( node_arena::current() )
+			node_arena::current()->add( this );
+	}
+
 	virtual ~node( void ) {}
 };
 
@@ -123,6 +158,11 @@ private:
 class term : public node
 {
 public:
+	term( const vector<node *> &factors )
+		: _factors( factors )
+	{
+	}
+
 	term( node *factors, node *n )
 	{
 		term *t = dynamic_cast<term*>( factors );
@@ -146,6 +186,17 @@ private:
 class expression : public node
 {
 public:
+	expression( const vector<node *> &exprs )
+		: _short( true ), _exprs( exprs )
+	{
+		for ( size_t i = 0; i < _exprs.size(); ++i )
+		{
+			literal *lit = dynamic_cast<literal*>( _exprs[i] );
+			if ( !lit || lit->value().size() > 3 )
+				_short = false;
+		}
+	}
+
 	expression( node *exprs, node *n )
 		: _short( true )
 	{
@@ -198,6 +249,10 @@ private:
 class productions : public node
 {
 public:
+	productions( void )
+	{
+	}
+
 	productions( node *prods, node *n )
 	{
 		productions *p = dynamic_cast<productions*>( prods );
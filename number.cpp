@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cmath>
+#include <cstdio>
+#include <stdint.h>
+
+#include "number.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+const uint64_t powers[] =
+{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL, 1000000000ULL
+};
+
+char *write_digits( char *p, uint64_t v, int width )
+{
+	char tmp[24];
+	int n = 0;
+	do
+	{
+		tmp[n++] = char( '0' + v % 10 );
+		v /= 10;
+	} while ( v > 0 );
+	while ( n < width )
+		tmp[n++] = '0';
+	while ( n > 0 )
+		*p++ = tmp[--n];
+	return p;
+}
+
+}
+
+////////////////////////////////////////
+
+size_t format_number( char *buf, float v, int decimals, bool short_form )
+{
+	if ( decimals < 0 )
+		decimals = 0;
+	if ( decimals > 9 )
+		decimals = 9;
+
+	double d = v;
+	if ( !std::isfinite( d ) )
+	{
+		buf[0] = '0';
+		return 1;
+	}
+
+	bool neg = d < 0.0;
+	double scaled = std::floor( std::fabs( d ) * double( powers[decimals] ) + 0.5 );
+
+	// Too big for the integer path; these never show up as coordinates.
+	if ( scaled >= 1e18 )
+	{
+		int n = snprintf( buf, number::max_size, "%.0f", d );
+		return size_t( n );
+	}
+
+	uint64_t fixed = uint64_t( scaled );
+	char *p = buf;
+	if ( neg && fixed != 0 )
+		*p++ = '-';
+
+	uint64_t whole = fixed / powers[decimals];
+	uint64_t frac = fixed % powers[decimals];
+	if ( whole != 0 || frac == 0 || !short_form )
+		p = write_digits( p, whole, 1 );
+
+	if ( frac != 0 )
+	{
+		int width = decimals;
+		while ( frac % 10 == 0 )
+		{
+			frac /= 10;
+			--width;
+		}
+		*p++ = '.';
+		p = write_digits( p, frac, width );
+	}
+
+	return size_t( p - buf );
+}
+
+////////////////////////////////////////
+
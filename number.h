@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <iostream>
+#include <cstddef>
+
+using namespace std;
+
+////////////////////////////////////////
+
+// Write v into buf with at most "decimals" digits after the point.
+// Trailing zeros (and the point) are dropped, and the result never
+// depends on the current locale.  In short form the zero before the
+// point of a fraction is dropped as well (".5", "-.25").  Returns the
+// number of characters written (at most number::max_size).
+size_t format_number( char *buf, float v, int decimals, bool short_form = false );
+
+////////////////////////////////////////
+
+class number
+{
+public:
+	enum { max_size = 48 };
+
+	number( float v, int decimals, bool short_form = false )
+		: _size( format_number( _buf, v, decimals, short_form ) )
+	{
+	}
+
+	inline const char *data( void ) const { return _buf; }
+	inline size_t size( void ) const { return _size; }
+
+private:
+	char _buf[max_size];
+	size_t _size;
+};
+
+////////////////////////////////////////
+
+inline ostream &operator<<( ostream &out, const number &n )
+{
+	return out.write( n.data(), n.size() );
+}
+
+////////////////////////////////////////
+
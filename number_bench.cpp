@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "number.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+const int runs = 5;
+
+template <class F>
+double best_seconds( F f )
+{
+	double best = 1e30;
+	for ( int r = 0; r < runs; ++r )
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		f();
+		chrono::duration<double> d = chrono::steady_clock::now() - start;
+		best = min( best, d.count() );
+	}
+	return best;
+}
+
+}
+
+////////////////////////////////////////
+
+// Formats coordinates like the ones in SVG output (multiples of a
+// hundredth up to 4000) with format_number(), and with iostream as the
+// backends did before it, and prints how many MB of text each writes
+// per second.  Each is timed as the best of 5 runs.
+//
+// Usage: number_bench [count]
+int main( int argc, char *argv[] )
+{
+	size_t count = argc > 1 ? size_t( atol( argv[1] ) ) : 1000000;
+
+	mt19937 rng( 1 );
+	uniform_real_distribution<float> coord( 0.F, 4000.F );
+	vector<float> values( count );
+	for ( size_t i = 0; i < count; ++i )
+		values[i] = roundf( coord( rng ) * 100.F ) / 100.F;
+
+	size_t bytes = 0;
+	unsigned check = 0;
+	double fast = best_seconds( [&]()
+	{
+		char buf[number::max_size];
+		bytes = 0;
+		for ( size_t i = 0; i < count; ++i )
+		{
+			size_t n = format_number( buf, values[i], 3 );
+			check += unsigned( buf[n - 1] );
+			bytes += n;
+		}
+	} );
+
+	size_t stream_bytes = 0;
+	double slow = best_seconds( [&]()
+	{
+		ostringstream out;
+		for ( size_t i = 0; i < count; ++i )
+			out << values[i] << ' ';
+		stream_bytes = out.str().size() - count;
+	} );
+
+	cout << count << " numbers, checksum " << check << '\n';
+	cout << "format_number: " << bytes / fast / 1e6 << " MB/s (" << fast * 1e9 / double( count ) << " ns each)\n";
+	cout << "ostream:       " << stream_bytes / slow / 1e6 << " MB/s (" << slow * 1e9 / double( count ) << " ns each)\n";
+	return 0;
+}
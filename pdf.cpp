@@ -0,0 +1,650 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <zlib.h>
+
+#include "pdf.h"
+#include "render.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+// A4 in points, with half inch margins and a gap between the parts
+// stacked on a page.
+const float page_width = 595.28F;
+const float page_height = 841.89F;
+const float margin = 36.F;
+const float gap = 12.F;
+
+// Pixels are drawn at the same size as in a browser.  Parts too big
+// for A4 get a page of their own, up to the largest page readers take.
+const float pixel = 0.75F;
+const float page_max = 14400.F;
+
+// Control point distance of a quarter circle as one cubic.
+const float kappa = 0.5523F;
+
+// Strokes reach a pixel past the part's box.
+const float bleed = 2.F;
+
+// The colors of svg.cpp's stylesheet.
+const char *fill_ops[] = { "0 g\n", ".627 0 0 rg\n", "0 .502 0 rg\n", ".247 0 .867 rg\n" };
+
+int text_color( Class cl )
+{
+	switch ( cl )
+	{
+		case NONTERM: return 1;
+		case LITERAL: return 2;
+		case KEYWORD: return 3;
+		default: return 0;
+	}
+}
+
+////////////////////////////////////////
+
+inline string ref( int id )
+{
+	return to_string( id ) + " 0 R";
+}
+
+////////////////////////////////////////
+
+// Text is UTF-8, and the font uses WinAnsiEncoding, which has Latin-1
+// at the same code points; anything else becomes '?'.
+void string_literal( buffer &o, const string &s )
+{
+	o << '(';
+	for ( size_t i = 0; i < s.size(); ++i )
+	{
+		unsigned c = static_cast<unsigned char>( s[i] );
+		if ( c >= 0x80 )
+		{
+			int n = c >= 0xF0 ? 3 : ( c >= 0xE0 ? 2 : ( c >= 0xC0 ? 1 : 0 ) );
+			unsigned cp = c & ( 0x3Fu >> n );
+			for ( ; n > 0 && i + 1 < s.size() && ( s[i+1] & 0xC0 ) == 0x80; --n )
+				cp = ( cp << 6 ) | ( s[++i] & 0x3F );
+			c = n == 0 && cp >= 0xA0 && cp <= 0xFF ? cp : '?';
+		}
+
+		if ( c == '(' || c == ')' || c == '\\' )
+			o << '\\' << char( c );
+		else if ( c < 0x20 || c >= 0x80 )
+		{
+			char esc[4] = { '\\', char( '0' + ( c >> 6 ) ), char( '0' + ( ( c >> 3 ) & 7 ) ), char( '0' + ( c & 7 ) ) };
+			o.append( esc, 4 );
+		}
+		else
+			o << char( c );
+	}
+	o << ')';
+}
+
+}
+
+////////////////////////////////////////
+
+draw_pdf::draw_pdf( buffer &o )
+	: draw( o ), offset( 0 ), in_part( false ), id_w( 0 ), id_h( 0 ), part_w( 0 ), part_h( 0 ), page_id( 0 ), page_w( 0 ), page_h( 0 ), page_y( 0 ),
+	  path_class( LINE ), cur_x( 0 ), cur_y( 0 ), fill( 0 )
+{
+	set_precision( 2 );
+}
+
+////////////////////////////////////////
+
+draw_pdf::~draw_pdf( void )
+{
+}
+
+////////////////////////////////////////
+
+// The catalog and the page tree are objects 1 and 2, written last, and
+// the font is object 3.
+void draw_pdf::begin( const string &t )
+{
+	title = t;
+	offset = 0;
+	offsets.clear();
+	pages.clear();
+	bookmarks.clear();
+	page_id = 0;
+
+	object << "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n";
+	flush_object();
+	new_id();
+	new_id();
+	object_begin( new_id() );
+	object << "<</Type/Font/Subtype/Type1/BaseFont/Courier-Bold/Encoding/WinAnsiEncoding>>\n";
+	object_end();
+}
+
+////////////////////////////////////////
+
+void draw_pdf::end( void )
+{
+	close_path();
+	if ( page_id == 0 )
+		page_begin( page_width, page_height );
+	page_end();
+
+	int outlines = 0;
+	if ( !bookmarks.empty() )
+	{
+		outlines = new_id();
+		int first = int( offsets.size() ) + 1;
+		int last = first + int( bookmarks.size() ) - 1;
+		object_begin( outlines );
+		object << "<</Type/Outlines/First " << ref( first ) << "/Last " << ref( last ) << "/Count " << to_string( bookmarks.size() ) << ">>\n";
+		object_end();
+
+		for ( size_t i = 0; i < bookmarks.size(); ++i )
+		{
+			const bookmark &b = bookmarks[i];
+			int id = new_id();
+			object_begin( id );
+			object << "<</Title";
+			string_literal( object, b.title );
+			object << "/Parent " << ref( outlines );
+			if ( id > first )
+				object << "/Prev " << ref( id - 1 );
+			if ( id < last )
+				object << "/Next " << ref( id + 1 );
+			object << "/Dest[" << ref( b.page ) << "/XYZ " << num( margin ) << ' ' << num( b.top ) << " null]>>\n";
+			object_end();
+		}
+	}
+
+	int info = new_id();
+	object_begin( info );
+	object << "<</Title";
+	string_literal( object, title );
+	object << "/Producer(draw_grammar)>>\n";
+	object_end();
+
+	object_begin( 2 );
+	object << "<</Type/Pages/Kids[";
+	for ( size_t i = 0; i < pages.size(); ++i )
+		object << ( i > 0 ? " " : "" ) << ref( pages[i] );
+	object << "]/Count " << to_string( pages.size() ) << ">>\n";
+	object_end();
+
+	object_begin( 1 );
+	object << "<</Type/Catalog/Pages " << ref( 2 );
+	if ( outlines )
+		object << "/Outlines " << ref( outlines ) << "/PageMode/UseOutlines";
+	object << ">>\n";
+	object_end();
+
+	// Cross reference entries are exactly 20 bytes each.
+	size_t xref = offset;
+	object << "xref\n0 " << to_string( offsets.size() + 1 ) << "\n0000000000 65535 f \n";
+	for ( size_t i = 0; i < offsets.size(); ++i )
+	{
+		char entry[24];
+		snprintf( entry, sizeof( entry ), "%010zu 00000 n \n", offsets[i] );
+		object.append( entry, 20 );
+	}
+	object << "trailer\n<</Size " << to_string( offsets.size() + 1 ) << "/Root " << ref( 1 ) << "/Info " << ref( info ) << ">>\n"
+		"startxref\n" << to_string( xref ) << "\n%%EOF\n";
+	flush_object();
+}
+
+////////////////////////////////////////
+
+void draw_pdf::id_begin( float x, float y, float w, float h, const string &name )
+{
+	id_w = w;
+	id_h = h;
+	push_translate( point( x, y ) );
+}
+
+////////////////////////////////////////
+
+// Anything drawn outside of a part is a part the size of the whole.
+void draw_pdf::id_end( void )
+{
+	close_path();
+	pop_translate();
+	if ( content.size() > 0 )
+		form_end();
+}
+
+////////////////////////////////////////
+
+void draw_pdf::link_begin( const string &name )
+{
+}
+
+////////////////////////////////////////
+
+void draw_pdf::link_end( void )
+{
+}
+
+////////////////////////////////////////
+
+void draw_pdf::part_begin( float x, float y, float w, float h, const string &name )
+{
+	close_path();
+	in_part = true;
+	part_w = w;
+	part_h = h;
+	part_name = name;
+	content.clear();
+	push_translate( point( -xx( x ), -yy( y ) ) );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::part_end( void )
+{
+	close_path();
+	pop_translate();
+	form_end();
+	in_part = false;
+}
+
+////////////////////////////////////////
+
+// Outlines are placed as in the SVG: half a pixel in, stroked 2 pixels
+// wide (1 for tests).
+void draw_pdf::circle( float x, float y, float r, Class cl )
+{
+	close_path();
+	float cx = xx(x+0.5F), cy = yy(y+0.5F);
+	point_to( 'm', cx + r, cy );
+	arc_to( cx, cy, cx, cy + r );
+	arc_to( cx, cy, cx - r, cy );
+	arc_to( cx, cy, cx, cy - r );
+	arc_to( cx, cy, cx + r, cy );
+	body() << "h S\n";
+}
+
+////////////////////////////////////////
+
+void draw_pdf::box( float x, float y, float w, float h, Class cl )
+{
+	close_path();
+	buffer &o = body();
+	if ( cl == TEST )
+		o << "1 w ";
+	o << num( xx(x+0.5F) ) << ' ' << num( yy(y+0.5F) ) << ' ' << num( w ) << ' ' << num( h ) << " re S\n";
+	if ( cl == TEST )
+		o << "2 w\n";
+}
+
+////////////////////////////////////////
+
+void draw_pdf::round( float x, float y, float w, float h, Class cl )
+{
+	close_path();
+	float bx = xx(x+0.5F), by = yy(y+0.5F), r = h/2.F;
+	point_to( 'm', bx + r, by );
+	point_to( 'l', bx + w - r, by );
+	arc_to( bx + w - r, by + r, bx + w, by + r );
+	arc_to( bx + w - r, by + r, bx + w - r, by + h );
+	point_to( 'l', bx + r, by + h );
+	arc_to( bx + r, by + r, bx, by + r );
+	arc_to( bx + r, by + r, bx + r, by );
+	body() << "h S\n";
+}
+
+////////////////////////////////////////
+
+void draw_pdf::text( float x, float y, float w, float h, const string &text, Class cl )
+{
+	close_path();
+	label( xx(x), yy(y + h/2.F), text, cl );
+}
+
+////////////////////////////////////////
+
+// Courier is 0.6 em wide, so 12 pixels at 20.
+void draw_pdf::text_center( float x, float y, float w, float h, const string &text, Class cl )
+{
+	close_path();
+	label( xx(x + w/2.F) - float( text.size() ) * 6.F, yy(y + h/2.F), text, cl );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_begin( float x, float y, Class cl )
+{
+	path_class = cl;
+	if ( cl == ARROW )
+		fill_color( 0 );
+	point_to( 'm', xx(x), yy(y) );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_move( float x, float y )
+{
+	point_to( 'm', xx(x), yy(y) );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_h_by( float x )
+{
+	point_to( 'l', cur_x + x, cur_y );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_v_by( float y )
+{
+	point_to( 'l', cur_x, cur_y + y );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_h_to( float x )
+{
+	point_to( 'l', xx(x), cur_y );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_v_to( float y )
+{
+	point_to( 'l', cur_x, yy(y) );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_to( float x, float y )
+{
+	point_to( 'l', xx(x), yy(y) );
+}
+
+////////////////////////////////////////
+
+// The same quarter circle as draw_png::path_arc().
+void draw_pdf::path_arc( float r, Arc a )
+{
+	float ex = r, ey = r;
+	switch ( a )
+	{
+		case RIGHT_UP: ey = -r; break;
+		case RIGHT_DOWN: break;
+		case LEFT_UP: ex = -r; ey = -r; break;
+		case LEFT_DOWN: ex = -r; break;
+		case UP_RIGHT: ey = -r; break;
+		case UP_LEFT: ex = -r; ey = -r; break;
+		case DOWN_RIGHT: break;
+		case DOWN_LEFT: ex = -r; break;
+	}
+
+	bool across = a == RIGHT_UP || a == RIGHT_DOWN || a == LEFT_UP || a == LEFT_DOWN;
+	float cx = across ? cur_x : cur_x + ex;
+	float cy = across ? cur_y + ey : cur_y;
+	arc_to( cx, cy, cur_x + ex, cur_y + ey );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_arrow_left( float size )
+{
+	float x = cur_x, y = cur_y;
+	point_to( 'l', x + size, y + size/2 );
+	point_to( 'l', x + size, y - size/2 );
+	body() << "h\n";
+	cur_x = x;
+	cur_y = y;
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_arrow_right( float size )
+{
+	float x = cur_x, y = cur_y;
+	point_to( 'l', x - size, y - size/2 );
+	point_to( 'l', x - size, y + size/2 );
+	body() << "h\n";
+	cur_x = x;
+	cur_y = y;
+}
+
+////////////////////////////////////////
+
+void draw_pdf::path_arrow_down( float size )
+{
+	float x = cur_x, y = cur_y;
+	point_to( 'l', x - size/2, y - size );
+	point_to( 'l', x + size/2, y - size );
+	body() << "h\n";
+	cur_x = x;
+	cur_y = y;
+}
+
+////////////////////////////////////////
+
+// Arrows are filled; every other path is stroked.
+void draw_pdf::path_end( void )
+{
+	body() << ( path_class == ARROW ? "f\n" : "S\n" );
+}
+
+////////////////////////////////////////
+
+// The content of the current part.  Each starts out flipped so y runs
+// down as in the layout, with the line width and font set.
+buffer &draw_pdf::body( void )
+{
+	if ( content.size() == 0 )
+	{
+		float h = in_part ? part_h : id_h;
+		content << "1 0 0 -1 0 " << num( h ) << " cm\n2 w\n/F 20 Tf\n";
+		fill = 0;
+	}
+	return content;
+}
+
+////////////////////////////////////////
+
+void draw_pdf::point_to( char op, float x, float y )
+{
+	body() << num( x ) << ' ' << num( y ) << ' ' << op << '\n';
+	cur_x = x;
+	cur_y = y;
+}
+
+////////////////////////////////////////
+
+// A quarter circle around (cx, cy) from the current point to (x, y).
+// The tangent at each end is parallel to the radius to the other end.
+void draw_pdf::arc_to( float cx, float cy, float x, float y )
+{
+	body() << num( cur_x + kappa * ( x - cx ) ) << ' ' << num( cur_y + kappa * ( y - cy ) ) << ' '
+		<< num( x + kappa * ( cur_x - cx ) ) << ' ' << num( y + kappa * ( cur_y - cy ) ) << ' '
+		<< num( x ) << ' ' << num( y ) << " c\n";
+	cur_x = x;
+	cur_y = y;
+}
+
+////////////////////////////////////////
+
+void draw_pdf::fill_color( int color )
+{
+	buffer &o = body();
+	if ( color != fill )
+	{
+		o << fill_ops[color];
+		fill = color;
+	}
+}
+
+////////////////////////////////////////
+
+// Text matrices flip the glyphs back upright.  The baseline sits half
+// the cap height below the middle of the box.
+void draw_pdf::label( float x, float y, const string &text, Class cl )
+{
+	fill_color( text_color( cl ) );
+	content << "BT 1 0 0 -1 " << num( x ) << ' ' << num( y + 5.6F ) << " Tm";
+	string_literal( content, text );
+	content << "Tj ET\n";
+}
+
+////////////////////////////////////////
+
+// Place the finished part on a page and write it out as a form.
+void draw_pdf::form_end( void )
+{
+	float w = in_part ? part_w : id_w;
+	float h = in_part ? part_h : id_h;
+	float s = pixel;
+	float top = page_y + ( page_forms.empty() ? 0.F : gap );
+	if ( w * s <= page_width - 2*margin && h * s <= page_height - 2*margin )
+	{
+		if ( page_id == 0 || top + h * s > page_h - margin )
+		{
+			page_end();
+			page_begin( page_width, page_height );
+			top = margin;
+		}
+	}
+	else
+	{
+		s = std::min( s, ( page_max - 2*margin ) / std::max( w, h ) );
+		page_end();
+		page_begin( w * s + 2*margin, h * s + 2*margin );
+		top = margin;
+	}
+
+	int id = new_id();
+	buffer dict;
+	dict << "/Type/XObject/Subtype/Form/BBox[" << num( -bleed ) << ' ' << num( -bleed ) << ' ' << num( w + bleed ) << ' ' << num( h + bleed )
+		<< "]/Resources<</Font<</F " << ref( 3 ) << ">>>>";
+	body();
+	stream_object( id, dict.str(), content );
+	content.clear();
+
+	page << "q " << num( s ) << " 0 0 " << num( s ) << ' ' << num( margin ) << ' ' << num( page_h - top - h * s ) << " cm/X" << to_string( id ) << " Do Q\n";
+	page_forms.push_back( id );
+	if ( in_part && !part_name.empty() && part_name != title_part )
+	{
+		bookmark b = { part_name, page_id, page_h - top };
+		bookmarks.push_back( b );
+	}
+	page_y = top + h * s;
+
+	// A page of its own is full.
+	if ( s != pixel || page_w != page_width )
+		page_y = page_h;
+}
+
+////////////////////////////////////////
+
+void draw_pdf::page_begin( float w, float h )
+{
+	page_id = new_id();
+	page_w = w;
+	page_h = h;
+	page_y = margin;
+	page.clear();
+	page_forms.clear();
+}
+
+////////////////////////////////////////
+
+void draw_pdf::page_end( void )
+{
+	if ( page_id == 0 )
+		return;
+
+	int contents = new_id();
+	stream_object( contents, string(), page );
+
+	object_begin( page_id );
+	object << "<</Type/Page/Parent " << ref( 2 ) << "/MediaBox[0 0 " << num( page_w ) << ' ' << num( page_h ) << "]/Resources<</XObject<<";
+	for ( size_t i = 0; i < page_forms.size(); ++i )
+		object << "/X" << to_string( page_forms[i] ) << ' ' << ref( page_forms[i] );
+	object << ">>>>/Contents " << ref( contents ) << ">>\n";
+	object_end();
+
+	pages.push_back( page_id );
+	page_id = 0;
+}
+
+////////////////////////////////////////
+
+int draw_pdf::new_id( void )
+{
+	offsets.push_back( 0 );
+	return int( offsets.size() );
+}
+
+////////////////////////////////////////
+
+void draw_pdf::object_begin( int id )
+{
+	offsets[size_t( id - 1 )] = offset + object.size();
+	object << to_string( id ) << " 0 obj\n";
+}
+
+////////////////////////////////////////
+
+void draw_pdf::object_end( void )
+{
+	object << "endobj\n";
+	flush_object();
+}
+
+////////////////////////////////////////
+
+void draw_pdf::flush_object( void )
+{
+	out.append( object.data(), object.size() );
+	offset += object.size();
+	object.clear();
+}
+
+////////////////////////////////////////
+
+// Streams are deflated in one go, straight into the output.
+void draw_pdf::stream_object( int id, const string &dict, const buffer &data )
+{
+	uLongf size = compressBound( data.size() );
+	packed.resize( size );
+	if ( compress2( reinterpret_cast<Bytef *>( packed.data() ), &size, reinterpret_cast<const Bytef *>( data.data() ), data.size(), Z_DEFAULT_COMPRESSION ) != Z_OK )
+		throw runtime_error( "failed to compress PDF stream" );
+
+	object_begin( id );
+	object << "<<" << dict << "/Length " << to_string( size ) << "/Filter/FlateDecode>>\nstream\n";
+	flush_object();
+	out.append( reinterpret_cast<const char *>( packed.data() ), size );
+	offset += size;
+	object << "\nendstream\nendobj\n";
+	flush_object();
+}
+
+////////////////////////////////////////
@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "draw.h"
+
+using namespace std;
+
+// Writes a PDF in one pass.  Every part (the title and each production)
+// becomes a form XObject with a deflated content stream, and the forms
+// are stacked onto A4 pages as they are finished; a part too big for
+// A4 gets a page of its own.  Each production also gets a bookmark.
+// Text is set in the standard Courier-Bold, so no font is embedded.
+class draw_pdf : public draw
+{
+public:
+	draw_pdf( buffer &o );
+	virtual ~draw_pdf( void );
+
+	virtual void begin( const string &title );
+	virtual void end( void );
+
+	virtual void id_begin( float x, float y, float w, float h, const string &name );
+	virtual void id_end();
+
+	virtual void link_begin( const string &name ) final;
+	virtual void link_end() final;
+
+	virtual void part_begin( float x, float y, float w, float h, const string &name );
+	virtual void part_end( void );
+
+	virtual void circle( float x, float y, float r, Class cl ) final;
+	virtual void box( float x, float y, float w, float h, Class cl ) final;
+	virtual void round( float x, float y, float w, float h, Class c ) final;
+	virtual void text( float x, float y, float w, float h, const string &text, Class cl ) final;
+	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl ) final;
+
+	virtual void path_begin( float x, float y, Class cl ) final;
+	virtual void path_move( float x, float y ) final;
+
+	virtual void path_h_by( float x ) final;
+	virtual void path_v_by( float y ) final;
+	virtual void path_h_to( float x ) final;
+	virtual void path_v_to( float y ) final;
+	virtual void path_to( float x, float y ) final;
+	virtual void path_arc( float r, Arc a ) final;
+	virtual void path_arrow_left( float size ) final;
+	virtual void path_arrow_right( float size ) final;
+	virtual void path_arrow_down( float size ) final;
+
+	virtual void path_end( void ) final;
+
+private:
+	// Coordinates drop the zero before the point.
+	inline number num( float v ) const { return number( v, precision, true ); }
+
+	buffer &body( void );
+	void point_to( char op, float x, float y );
+	void arc_to( float cx, float cy, float x, float y );
+	void fill_color( int color );
+	void label( float x, float y, const string &text, Class cl );
+
+	void form_end( void );
+	void page_begin( float w, float h );
+	void page_end( void );
+
+	int new_id( void );
+	void object_begin( int id );
+	void object_end( void );
+	void flush_object( void );
+	void stream_object( int id, const string &dict, const buffer &data );
+
+	struct bookmark
+	{
+		string title;
+		int page;
+		float top;
+	};
+
+	string title;
+	buffer object;
+	size_t offset;
+	vector<size_t> offsets;
+	vector<unsigned char> packed;
+
+	// The part being drawn.
+	buffer content;
+	bool in_part;
+	float id_w, id_h;
+	float part_w, part_h;
+	string part_name;
+
+	// The page being filled: the forms on it, the content that places
+	// them, and how far down it is filled.
+	int page_id;
+	float page_w, page_h;
+	float page_y;
+	vector<int> page_forms;
+	buffer page;
+	vector<int> pages;
+	vector<bookmark> bookmarks;
+
+	Class path_class;
+	float cur_x, cur_y;
+	int fill;
+};
+
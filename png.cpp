@@ -0,0 +1,790 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "png.h"
+#include "deflate.h"
+#include "font.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+// Pixels are 0xAABBGGRR, so they are R, G, B, A in memory order on
+// little-endian machines; only the encoder looks at the channels.
+inline uint32_t rgb( unsigned r, unsigned g, unsigned b )
+{
+	return 0xFF000000 | ( b << 16 ) | ( g << 8 ) | r;
+}
+
+const uint32_t white = rgb( 255, 255, 255 );
+const uint32_t black = rgb( 0, 0, 0 );
+
+const int band_rows = 64;
+
+////////////////////////////////////////
+
+// The colors of svg.cpp's stylesheet.
+uint32_t text_color( Class cl )
+{
+	switch ( cl )
+	{
+		case NONTERM: return rgb( 160, 0, 0 );
+		case LITERAL: return rgb( 0, 128, 0 );
+		case KEYWORD: return rgb( 63, 0, 221 );
+		default: return black;
+	}
+}
+
+////////////////////////////////////////
+
+inline uint32_t blend( uint32_t d, uint32_t s, int a )
+{
+	uint32_t r = 0xFF000000;
+	for ( int shift = 0; shift < 24; shift += 8 )
+	{
+		int dc = int( ( d >> shift ) & 0xFF );
+		int sc = int( ( s >> shift ) & 0xFF );
+		r |= uint32_t( dc + ( ( sc - dc ) * a + ( sc > dc ? 127 : -127 ) ) / 255 ) << shift;
+	}
+	return r;
+}
+
+////////////////////////////////////////
+
+void fill( uint32_t *p, int n, uint32_t color )
+{
+#ifdef __SSE2__
+	__m128i c = _mm_set1_epi32( int( color ) );
+	for ( ; n >= 4; n -= 4, p += 4 )
+		_mm_storeu_si128( reinterpret_cast<__m128i *>( p ), c );
+#endif
+	for ( ; n > 0; --n )
+		*p++ = color;
+}
+
+////////////////////////////////////////
+
+struct paint_span
+{
+	draw_png::band *b;
+	int width;
+	int rows;
+	uint32_t color;
+
+	void operator()( int x, int y, int n, float c )
+	{
+		if ( y >= rows )
+			return;
+		b->mark( y, x, x + n, width );
+		uint32_t *p = &b->pixels[size_t( y ) * size_t( width ) + size_t( x )];
+		int a = int( c * 255.F + 0.5F );
+		if ( a >= 255 )
+			fill( p, n, color );
+		else
+		{
+			for ( int i = 0; i < n; ++i )
+				p[i] = blend( p[i], color, a );
+		}
+	}
+};
+
+////////////////////////////////////////
+
+// A rounded rectangle as a polygon, wound like the stroke quads of
+// raster.cpp; with r = w/2 = h/2 it is a circle.
+vector<raster_point> rounded( float x, float y, float w, float h, float r )
+{
+	vector<raster_point> p;
+	if ( w <= 0.F || h <= 0.F )
+		return p;
+	r = std::max( 0.F, std::min( r, std::min( w, h ) / 2.F ) );
+	int steps = r > 0.F ? std::min( 16, int( r / 2.F ) + 2 ) : 0;
+	const float cx[4] = { x + w - r, x + w - r, x + r, x + r };
+	const float cy[4] = { y + r, y + h - r, y + h - r, y + r };
+	for ( int k = 0; k < 4; ++k )
+	{
+		for ( int i = 0; i <= steps; ++i )
+		{
+			float a = float( M_PI ) / 2.F * ( float( k - 1 ) + float( i ) / float( std::max( steps, 1 ) ) );
+			raster_point q = { cx[k] + r * cos( a ), cy[k] + r * sin( a ) };
+			p.push_back( q );
+			if ( steps == 0 )
+				break;
+		}
+	}
+	return p;
+}
+
+////////////////////////////////////////
+
+void put32( unsigned char *p, uint32_t v )
+{
+	p[0] = (unsigned char)( v >> 24 );
+	p[1] = (unsigned char)( v >> 16 );
+	p[2] = (unsigned char)( v >> 8 );
+	p[3] = (unsigned char)( v );
+}
+
+////////////////////////////////////////
+
+// The CRC-32 that ends every chunk (the same as zlib's), a byte at a
+// time from a table.
+struct crc_table
+{
+	crc_table( void )
+	{
+		for ( uint32_t i = 0; i < 256; ++i )
+		{
+			uint32_t c = i;
+			for ( int k = 0; k < 8; ++k )
+				c = ( c & 1 ) ? 0xEDB88320 ^ ( c >> 1 ) : c >> 1;
+			entry[i] = c;
+		}
+	}
+
+	uint32_t entry[256];
+};
+
+const crc_table crcs;
+
+uint32_t update_crc( uint32_t crc, const unsigned char *p, size_t n )
+{
+	crc = ~crc;
+	for ( size_t i = 0; i < n; ++i )
+		crc = crcs.entry[( crc ^ p[i] ) & 0xFF] ^ ( crc >> 8 );
+	return ~crc;
+}
+
+////////////////////////////////////////
+
+void chunk( buffer &out, const char *type, const unsigned char *data, size_t n )
+{
+	unsigned char head[8];
+	put32( head, uint32_t( n ) );
+	memcpy( head + 4, type, 4 );
+	uint32_t crc = update_crc( 0, head + 4, 4 );
+	crc = update_crc( crc, data, n );
+	unsigned char tail[4];
+	put32( tail, crc );
+
+	out.append( reinterpret_cast<const char *>( head ), 8 );
+	if ( n > 0 )
+		out.append( reinterpret_cast<const char *>( data ), n );
+	out.append( reinterpret_cast<const char *>( tail ), 4 );
+}
+
+}
+
+////////////////////////////////////////
+
+draw_png::draw_png( buffer &o )
+	: draw( o ), width( 1 ), height( 1 ), path_class( LINE )
+{
+	cur.x = cur.y = 0.F;
+}
+
+////////////////////////////////////////
+
+draw_png::~draw_png( void )
+{
+}
+
+////////////////////////////////////////
+
+void draw_png::begin( const string &title )
+{
+}
+
+////////////////////////////////////////
+
+void draw_png::end( void )
+{
+	close_path();
+	encode();
+}
+
+////////////////////////////////////////
+
+// The strokes of the outermost boxes reach half a pixel past w and h.
+void draw_png::id_begin( float x, float y, float w, float h, const string &name )
+{
+	width = std::max( 1, int( ceil( w + 0.5F ) ) );
+	height = std::max( 1, int( ceil( h + 0.5F ) ) );
+	push_translate( point( x, y ) );
+}
+
+////////////////////////////////////////
+
+void draw_png::id_end( void )
+{
+	close_path();
+	pop_translate();
+}
+
+////////////////////////////////////////
+
+void draw_png::link_begin( const string &name )
+{
+}
+
+////////////////////////////////////////
+
+void draw_png::link_end( void )
+{
+}
+
+////////////////////////////////////////
+
+// Outlines are placed as in the SVG: half a pixel in, with a 2 pixel
+// stroke (1 for tests) centered on them.
+void draw_png::circle( float x, float y, float r, Class cl )
+{
+	close_path();
+	float cx = xx(x+0.5F), cy = yy(y+0.5F);
+	ring( rounded( cx - r - 1.F, cy - r - 1.F, 2*r + 2.F, 2*r + 2.F, r + 1.F ),
+		rounded( cx - r + 1.F, cy - r + 1.F, 2*r - 2.F, 2*r - 2.F, r - 1.F ), black );
+}
+
+////////////////////////////////////////
+
+void draw_png::box( float x, float y, float w, float h, Class cl )
+{
+	close_path();
+	float s = cl == TEST ? 0.5F : 1.F;
+	float bx = xx(x+0.5F), by = yy(y+0.5F);
+	ring( rounded( bx - s, by - s, w + 2*s, h + 2*s, 0.F ), rounded( bx + s, by + s, w - 2*s, h - 2*s, 0.F ), black );
+}
+
+////////////////////////////////////////
+
+void draw_png::round( float x, float y, float w, float h, Class cl )
+{
+	close_path();
+	float bx = xx(x+0.5F), by = yy(y+0.5F), r = h/2.F;
+	ring( rounded( bx - 1.F, by - 1.F, w + 2.F, h + 2.F, r + 1.F ), rounded( bx + 1.F, by + 1.F, w - 2.F, h - 2.F, r - 1.F ), black );
+}
+
+////////////////////////////////////////
+
+void draw_png::text( float x, float y, float w, float h, const string &text, Class cl )
+{
+	close_path();
+	label( xx(x), yy(y + h/2.F), latin1( text ), cl );
+}
+
+////////////////////////////////////////
+
+void draw_png::text_center( float x, float y, float w, float h, const string &text, Class cl )
+{
+	close_path();
+	string s = latin1( text );
+	label( xx(x + w/2.F) - float( s.size() * glyph_mask::advance ) / 2.F, yy(y + h/2.F), s, cl );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_begin( float x, float y, Class cl )
+{
+	path_class = cl;
+	subpath.clear();
+	cur.x = xx(x);
+	cur.y = yy(y);
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_move( float x, float y )
+{
+	subpath_end( false );
+	cur.x = xx(x);
+	cur.y = yy(y);
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_h_by( float x )
+{
+	cur.x += x;
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_v_by( float y )
+{
+	cur.y += y;
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_h_to( float x )
+{
+	cur.x = xx(x);
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_v_to( float y )
+{
+	cur.y = yy(y);
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_to( float x, float y )
+{
+	cur.x = xx(x);
+	cur.y = yy(y);
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+// A quarter circle to the same end point as draw_svg::path_arc().  It
+// turns from the first direction of a, so its center is level with the
+// start across that direction.
+void draw_png::path_arc( float r, Arc a )
+{
+	float ex = r, ey = r;
+	switch ( a )
+	{
+		case RIGHT_UP: ey = -r; break;
+		case RIGHT_DOWN: break;
+		case LEFT_UP: ex = -r; ey = -r; break;
+		case LEFT_DOWN: ex = -r; break;
+		case UP_RIGHT: ey = -r; break;
+		case UP_LEFT: ex = -r; ey = -r; break;
+		case DOWN_RIGHT: break;
+		case DOWN_LEFT: ex = -r; break;
+	}
+
+	bool across = a == RIGHT_UP || a == RIGHT_DOWN || a == LEFT_UP || a == LEFT_DOWN;
+	float cx = across ? cur.x : cur.x + ex;
+	float cy = across ? cur.y + ey : cur.y;
+	float a0 = atan2( cur.y - cy, cur.x - cx );
+	float a1 = atan2( cur.y + ey - cy, cur.x + ex - cx );
+	float sweep = a1 - a0;
+	if ( sweep > float( M_PI ) )
+		sweep -= 2.F * float( M_PI );
+	else if ( sweep < -float( M_PI ) )
+		sweep += 2.F * float( M_PI );
+
+	int steps = std::min( 16, int( r / 2.F ) + 2 );
+	for ( int i = 1; i < steps; ++i )
+	{
+		float t = a0 + sweep * float( i ) / float( steps );
+		raster_point p = { cx + r * cos( t ), cy + r * sin( t ) };
+		subpath.push_back( p );
+	}
+	cur.x += ex;
+	cur.y += ey;
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_arrow_left( float size )
+{
+	raster_point p[2] = { { cur.x + size, cur.y + size/2 }, { cur.x + size, cur.y - size/2 } };
+	subpath.insert( subpath.end(), p, p + 2 );
+	subpath_end( true );
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_arrow_right( float size )
+{
+	raster_point p[2] = { { cur.x - size, cur.y - size/2 }, { cur.x - size, cur.y + size/2 } };
+	subpath.insert( subpath.end(), p, p + 2 );
+	subpath_end( true );
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_arrow_down( float size )
+{
+	raster_point p[2] = { { cur.x - size/2, cur.y - size }, { cur.x + size/2, cur.y - size } };
+	subpath.insert( subpath.end(), p, p + 2 );
+	subpath_end( true );
+	subpath.push_back( cur );
+}
+
+////////////////////////////////////////
+
+void draw_png::path_end( void )
+{
+	subpath_end( false );
+}
+
+////////////////////////////////////////
+
+// Arrows are filled; every other path is stroked 2 pixels wide.  Each
+// subpath is a shape of its own, so the bands it does not reach can
+// skip it.
+void draw_png::subpath_end( bool closed )
+{
+	if ( path_class == ARROW )
+	{
+		if ( subpath.size() >= 3 )
+		{
+			shape( black );
+			polygon( subpath.data(), subpath.size() );
+		}
+	}
+	else if ( subpath.size() >= 2 )
+	{
+		vector<raster_point> quads;
+		stroke_quads( quads, subpath.data(), subpath.size(), 1.F, closed );
+		shape( black );
+		for ( size_t i = 0; i < quads.size(); i += 4 )
+			polygon( &quads[i], 4 );
+	}
+	subpath.clear();
+}
+
+////////////////////////////////////////
+
+void draw_png::shape( uint32_t color )
+{
+	item i;
+	i.color = color;
+	i.text = false;
+	i.first = polygons.size();
+	i.count = 0;
+	i.x = i.y = 0.F;
+	i.top = INT_MAX;
+	i.bottom = INT_MIN;
+	items.push_back( i );
+}
+
+////////////////////////////////////////
+
+void draw_png::polygon( const raster_point *p, size_t n )
+{
+	if ( n == 0 )
+		return;
+	item &i = items.back();
+	float top = p[0].y, bottom = p[0].y;
+	for ( size_t k = 1; k < n; ++k )
+	{
+		top = std::min( top, p[k].y );
+		bottom = std::max( bottom, p[k].y );
+	}
+	i.top = std::min( i.top, int( floor( top ) ) );
+	i.bottom = std::max( i.bottom, int( ceil( bottom ) ) );
+	points.insert( points.end(), p, p + n );
+	polygons.push_back( points.size() );
+	++i.count;
+}
+
+////////////////////////////////////////
+
+// A stroked outline: the outer edge, and the inner one wound the other
+// way to cut out the middle.
+void draw_png::ring( const vector<raster_point> &outer, const vector<raster_point> &inner, uint32_t color )
+{
+	shape( color );
+	polygon( outer.data(), outer.size() );
+	vector<raster_point> hole( inner.rbegin(), inner.rend() );
+	polygon( hole.data(), hole.size() );
+}
+
+////////////////////////////////////////
+
+void draw_png::label( float x, float y, const string &text, Class cl )
+{
+	item i;
+	i.color = text_color( cl );
+	i.text = true;
+	i.first = texts.size();
+	i.count = 0;
+	i.x = floor( x + 0.5F );
+	i.y = floor( y + 0.5F );
+	i.top = int( i.y ) - glyph_mask::center;
+	i.bottom = i.top + glyph_mask::height;
+	items.push_back( i );
+	texts.push_back( text );
+}
+
+////////////////////////////////////////
+
+// Only the tiles drawn on in the last use of the band need to be made
+// white again.
+void draw_png::render_band( int index, rasterizer &r, const vector<size_t> &list, band &b )
+{
+	int top = index * band_rows;
+	int rows = std::min( band_rows, height - top );
+	for ( int y = 0; y < band_rows; ++y )
+	{
+		uint32_t *p = &b.pixels[size_t( y ) * size_t( width )];
+		uint64_t *d = &b.dirty[size_t( y ) * size_t( b.words )];
+		for ( int w = 0; w < b.words; ++w )
+		{
+			for ( uint64_t m = d[w]; m != 0; m &= m - 1 )
+			{
+				int x = ( w * 64 + __builtin_ctzll( m ) ) * tile;
+				fill( p + x, std::min( int( tile ), width - x ), white );
+			}
+			d[w] = 0;
+		}
+	}
+	r.set_top( top );
+	paint_span span = { &b, width, rows, 0 };
+
+	for ( size_t k = 0; k < list.size(); ++k )
+	{
+		const item &i = items[list[k]];
+		if ( i.text )
+		{
+			const string &s = texts[i.first];
+			int gx0 = int( i.x ) - glyph_mask::left;
+			int y0 = std::max( i.top, top );
+			int y1 = std::min( i.bottom, top + rows );
+			for ( int y = y0; y < y1; ++y )
+				b.mark( y - top, gx0, gx0 + int( s.size() ) * glyph_mask::advance + 2 * glyph_mask::left, width );
+
+			for ( size_t c = 0; c < s.size(); ++c )
+			{
+				const glyph_mask &g = glyph( s[c] );
+				int gx = gx0 + int( c ) * glyph_mask::advance;
+				int x0 = std::max( gx, 0 );
+				int x1 = std::min( gx + int( glyph_mask::width ), width );
+				for ( int y = y0; y < y1; ++y )
+				{
+					const unsigned char *m = g.coverage[y - i.top];
+					uint32_t *p = &b.pixels[size_t( y - top ) * size_t( width )];
+					for ( int x = x0; x < x1; ++x )
+					{
+						int a = m[x - gx];
+						if ( a == 255 )
+							p[x] = i.color;
+						else if ( a > 0 )
+							p[x] = blend( p[x], i.color, a );
+					}
+				}
+			}
+		}
+		else
+		{
+			for ( size_t p = i.first; p < i.first + i.count; ++p )
+			{
+				size_t start = p > 0 ? polygons[p - 1] : 0;
+				r.polygon( &points[start], polygons[p] - start );
+			}
+			span.color = i.color;
+			r.sweep( span );
+		}
+	}
+}
+
+////////////////////////////////////////
+
+// Bands are handed out to the workers in order, and each renders into
+// the slot of a ring that the encoder has finished with.  The encoder
+// takes the bands in order as they are ready and compresses them as
+// RGB rows with the Up filter.  A diagram is mostly white, or repeats
+// the row above, which filters to zeros: only tiles drawn on in a row
+// or the one above are compared, and only those that differ are
+// filtered; run_deflate skips over the rest.
+void draw_png::encode( void )
+{
+	int bands = ( height + band_rows - 1 ) / band_rows;
+	vector< vector<size_t> > lists( bands );
+	for ( size_t i = 0; i < items.size(); ++i )
+	{
+		const item &it = items[i];
+		if ( it.bottom <= 0 || it.top >= height || it.top > it.bottom )
+			continue;
+		int b0 = std::max( it.top, 0 ) / band_rows;
+		int b1 = std::min( it.bottom - 1, height - 1 ) / band_rows;
+		for ( int b = b0; b <= b1; ++b )
+			lists[b].push_back( i );
+	}
+
+	int tiles = ( width + tile - 1 ) / tile;
+	int words = ( tiles + 63 ) / 64;
+	int workers = std::max( 1, int( thread::hardware_concurrency() ) );
+	int slots = std::min( bands, workers * 2 );
+	vector<band> ring( slots );
+	for ( int s = 0; s < slots; ++s )
+	{
+		ring[s].words = words;
+		ring[s].pixels.assign( size_t( width ) * band_rows, white );
+		ring[s].dirty.assign( size_t( words ) * band_rows, 0 );
+	}
+	vector<int> rendered( slots, -1 );
+	vector<int> allowed( slots );
+	for ( int s = 0; s < slots; ++s )
+		allowed[s] = s;
+
+	mutex lock;
+	condition_variable changed;
+	atomic<int> next( 0 );
+
+	vector<thread> pool;
+	for ( int w = 0; w < std::min( workers, bands ); ++w )
+	{
+		pool.push_back( thread( [&]()
+		{
+			rasterizer r( width, 0, band_rows );
+			while ( true )
+			{
+				int b = next++;
+				if ( b >= bands )
+					break;
+				int s = b % slots;
+				{
+					unique_lock<mutex> l( lock );
+					while ( allowed[s] != b )
+						changed.wait( l );
+				}
+				render_band( b, r, lists[b], ring[s] );
+				lock_guard<mutex> l( lock );
+				rendered[s] = b;
+				changed.notify_all();
+			}
+		} ) );
+	}
+
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	out.append( reinterpret_cast<const char *>( signature ), 8 );
+	unsigned char ihdr[13] = { 0 };
+	put32( ihdr, uint32_t( width ) );
+	put32( ihdr + 4, uint32_t( height ) );
+	ihdr[8] = 8;
+	ihdr[9] = 2;
+	chunk( out, "IHDR", ihdr, 13 );
+
+	buffer &o = out;
+	run_deflate z( [&o]( const unsigned char *p, size_t n ) { chunk( o, "IDAT", p, n ); } );
+
+	// The last row of the band before, which the next band's first row
+	// is filtered against.  The row above the first one is black, so
+	// all of it is compared.
+	vector<uint32_t> above( width, 0 );
+	vector<uint64_t> above_dirty( words, 0 );
+	for ( int t = 0; t < tiles; ++t )
+		above_dirty[t / 64] |= uint64_t( 1 ) << ( t % 64 );
+
+	const unsigned char filter = 2;
+	vector<unsigned char> line( size_t( width ) * 3, 0 );
+	int line_left = 0, line_right = 0;
+
+	for ( int b = 0; b < bands; ++b )
+	{
+		int s = b % slots;
+		{
+			unique_lock<mutex> l( lock );
+			while ( rendered[s] != b )
+				changed.wait( l );
+		}
+
+		const band &bd = ring[s];
+		int rows = std::min( band_rows, height - b * band_rows );
+		for ( int y = 0; y < rows; ++y )
+		{
+			const uint32_t *p = &bd.pixels[size_t( y ) * size_t( width )];
+			const uint64_t *d = &bd.dirty[size_t( y ) * size_t( words )];
+			const uint32_t *up = y > 0 ? p - width : &above[0];
+			const uint64_t *ud = y > 0 ? d - words : &above_dirty[0];
+
+			if ( line_left < line_right )
+				memset( &line[size_t( line_left ) * 3], 0, size_t( line_right - line_left ) * 3 );
+			line_left = width;
+			line_right = 0;
+			for ( int w = 0; w < words; ++w )
+			{
+				for ( uint64_t m = d[w] | ud[w]; m != 0; m &= m - 1 )
+				{
+					int x0 = ( w * 64 + __builtin_ctzll( m ) ) * tile;
+					int x1 = std::min( x0 + tile, width );
+					if ( memcmp( p + x0, up + x0, size_t( x1 - x0 ) * sizeof( uint32_t ) ) == 0 )
+						continue;
+					for ( int x = x0; x < x1; ++x )
+					{
+						uint32_t c = p[x], a = up[x];
+						line[x*3] = (unsigned char)( c - a );
+						line[x*3 + 1] = (unsigned char)( ( c >> 8 ) - ( a >> 8 ) );
+						line[x*3 + 2] = (unsigned char)( ( c >> 16 ) - ( a >> 16 ) );
+					}
+					line_left = std::min( line_left, x0 );
+					line_right = std::max( line_right, x1 );
+				}
+			}
+
+			z.write( &filter, 1, 0, 1 );
+			z.write( &line[0], line.size(), size_t( std::min( line_left, line_right ) ) * 3, size_t( line_right ) * 3 );
+		}
+
+		// Keep the last row: only the tiles drawn on in it or in the row
+		// kept before can differ from white.
+		const uint32_t *p = &bd.pixels[size_t( rows - 1 ) * size_t( width )];
+		const uint64_t *d = &bd.dirty[size_t( rows - 1 ) * size_t( words )];
+		for ( int w = 0; w < words; ++w )
+		{
+			for ( uint64_t m = d[w] | above_dirty[w]; m != 0; m &= m - 1 )
+			{
+				int x0 = ( w * 64 + __builtin_ctzll( m ) ) * tile;
+				memcpy( &above[x0], p + x0, size_t( std::min( int( tile ), width - x0 ) ) * sizeof( uint32_t ) );
+			}
+			above_dirty[w] = d[w];
+		}
+
+		lock_guard<mutex> l( lock );
+		allowed[s] = b + slots;
+		changed.notify_all();
+	}
+
+	for ( size_t w = 0; w < pool.size(); ++w )
+		pool[w].join();
+
+	z.finish();
+	chunk( out, "IEND", NULL, 0 );
+}
+
+////////////////////////////////////////
+
@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "draw.h"
+#include "raster.h"
+
+using namespace std;
+
+// Draws straight to a PNG image.  Everything is turned into filled
+// polygons and text as it is drawn; end() then rasterizes bands of rows
+// on worker threads while the finished bands are compressed, in order,
+// into the image.
+class draw_png : public draw
+{
+public:
+	draw_png( buffer &o );
+	virtual ~draw_png( void );
+
+	virtual void begin( const string &title );
+	virtual void end( void );
+
+	virtual void id_begin( float x, float y, float w, float h, const string &name );
+	virtual void id_end();
+
+	virtual void link_begin( const string &name ) final;
+	virtual void link_end() final;
+
+	virtual void circle( float x, float y, float r, Class cl ) final;
+	virtual void box( float x, float y, float w, float h, Class cl ) final;
+	virtual void round( float x, float y, float w, float h, Class c ) final;
+	virtual void text( float x, float y, float w, float h, const string &text, Class cl ) final;
+	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl ) final;
+
+	virtual void path_begin( float x, float y, Class cl ) final;
+	virtual void path_move( float x, float y ) final;
+
+	virtual void path_h_by( float x ) final;
+	virtual void path_v_by( float y ) final;
+	virtual void path_h_to( float x ) final;
+	virtual void path_v_to( float y ) final;
+	virtual void path_to( float x, float y ) final;
+	virtual void path_arc( float r, Arc a ) final;
+	virtual void path_arrow_left( float size ) final;
+	virtual void path_arrow_right( float size ) final;
+	virtual void path_arrow_down( float size ) final;
+
+	virtual void path_end( void ) final;
+
+	// Rows are split into tiles of 64 pixels, and each row of a band
+	// has a bit per tile that may not be white.
+	enum { tile = 64 };
+
+	struct band
+	{
+		inline void mark( int y, int x0, int x1, int width )
+		{
+			x0 = std::max( x0, 0 ) / tile;
+			x1 = ( std::min( x1, width ) - 1 ) / tile;
+			uint64_t *d = &dirty[size_t( y ) * size_t( words )];
+			for ( int t = x0; t <= x1; ++t )
+				d[t / 64] |= uint64_t( 1 ) << ( t % 64 );
+		}
+
+		int words;
+		vector<uint32_t> pixels;
+		vector<uint64_t> dirty;
+	};
+
+private:
+	// One thing to paint: the polygons [first, first + count) of a
+	// shape, or the string texts[first] with its pen at (x, y).
+	struct item
+	{
+		uint32_t color;
+		bool text;
+		size_t first, count;
+		float x, y;
+		int top, bottom;
+	};
+
+	void shape( uint32_t color );
+	void polygon( const raster_point *p, size_t n );
+	void ring( const vector<raster_point> &outer, const vector<raster_point> &inner, uint32_t color );
+	void label( float x, float y, const string &text, Class cl );
+	void subpath_end( bool closed );
+
+	void render_band( int index, rasterizer &r, const vector<size_t> &list, band &b );
+	void encode( void );
+
+	int width, height;
+
+	vector<raster_point> points;
+	vector<size_t> polygons;
+	vector<item> items;
+	vector<string> texts;
+
+	Class path_class;
+	vector<raster_point> subpath;
+	raster_point cur;
+};
+
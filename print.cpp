@@ -58,7 +58,10 @@ ostream &operator<<( ostream &out, const node &node )
 		{
 			if ( i > 0 )
 				out << ' ';
-			out << *( n->at( i ) );
+			if ( dynamic_cast<const expression*>( n->at( i ) ) )
+				out << "( " << *( n->at( i ) ) << " )";
+			else
+				out << *( n->at( i ) );
 		}
 	}
 	else if ( const repetition *n = dynamic_cast<const repetition*>( &node ) )
@@ -67,7 +70,10 @@ ostream &operator<<( ostream &out, const node &node )
 	}
 	else if ( const onemore *n = dynamic_cast<const onemore*>( &node ) )
 	{
-		out << "< " << *n->expr() << " >";
+		out << "< " << *n->expr();
+		if ( n->sep() )
+			out << " ~ " << *n->sep();
+		out << " >";
 	}
 	else if ( const optional *n = dynamic_cast<const optional*>( &node ) )
 	{
@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "raster.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+void stroke_quads( vector<raster_point> &quads, const raster_point *p, size_t n, float half_width, bool closed )
+{
+	if ( n < 2 )
+		return;
+	size_t segs = closed ? n : n - 1;
+	for ( size_t i = 0; i < segs; ++i )
+	{
+		const raster_point &a = p[i];
+		const raster_point &b = p[( i + 1 ) % n];
+		float dx = b.x - a.x;
+		float dy = b.y - a.y;
+		float len = sqrt( dx*dx + dy*dy );
+		if ( len == 0.F )
+			continue;
+		dx *= half_width / len;
+		dy *= half_width / len;
+		float ea = ( closed || i > 0 ) ? 1.F : 0.F;
+		float eb = ( closed || i + 2 < n ) ? 1.F : 0.F;
+		float ax = a.x - dx * ea, ay = a.y - dy * ea;
+		float bx = b.x + dx * eb, by = b.y + dy * eb;
+		raster_point q[4] =
+		{
+			{ ax + dy, ay - dx },
+			{ bx + dy, by - dx },
+			{ bx - dy, by + dx },
+			{ ax - dy, ay + dx }
+		};
+		quads.insert( quads.end(), q, q + 4 );
+	}
+}
+
+////////////////////////////////////////
+
+rasterizer::rasterizer( int width, int top, int rows )
+	: _width( width ), _top( top ), _rows( rows ),
+	  _acc( size_t( width + 2 ) * size_t( rows ), 0.F ), _min_x( rows, width + 2 ), _max_x( rows, -1 ),
+	  _first( rows ), _last( -1 )
+{
+}
+
+////////////////////////////////////////
+
+// Adds the signed area the edge covers in each pixel it crosses, and
+// its height to the pixel after, so a running sum along the row gives
+// the coverage.  Clamping x to the band keeps the winding inside it
+// unchanged.
+void rasterizer::line( float x0, float y0, float x1, float y1 )
+{
+	if ( y0 == y1 )
+		return;
+
+	// Lines are clamped to the sides below, which only keeps their
+	// coverage exact if they do not cross a side: those are split there.
+	const float w = float( _width );
+	for ( float side = 0.F; side <= w; side += w )
+	{
+		if ( ( x0 < side ) != ( x1 < side ) && x0 != side && x1 != side )
+		{
+			float ys = y0 + ( side - x0 ) * ( y1 - y0 ) / ( x1 - x0 );
+			line( x0, y0, side, ys );
+			line( side, ys, x1, y1 );
+			return;
+		}
+		if ( w == 0.F )
+			break;
+	}
+
+	float dir = 1.F;
+	if ( y0 > y1 )
+	{
+		swap( x0, x1 );
+		swap( y0, y1 );
+		dir = -1.F;
+	}
+	y0 -= float( _top );
+	y1 -= float( _top );
+	if ( y1 <= 0.F || y0 >= float( _rows ) )
+		return;
+
+	x0 = std::max( 0.F, std::min( x0, w ) );
+	x1 = std::max( 0.F, std::min( x1, w ) );
+
+	float dxdy = ( x1 - x0 ) / ( y1 - y0 );
+	float x = x0;
+	int y = 0;
+	if ( y0 < 0.F )
+		x -= y0 * dxdy;
+	else
+		y = int( y0 );
+	int end = std::min( _rows, int( ceil( y1 ) ) );
+	if ( y < end )
+	{
+		_first = std::min( _first, y );
+		_last = std::max( _last, end - 1 );
+	}
+
+	for ( ; y < end; ++y )
+	{
+		float *acc = &_acc[size_t( y ) * size_t( _width + 2 )];
+		float dy = std::min( float( y + 1 ), y1 ) - std::max( float( y ), y0 );
+		float xnext = std::max( 0.F, std::min( x + dxdy * dy, w ) );
+		float d = dy * dir;
+		float xa = std::min( x, xnext );
+		float xb = std::max( x, xnext );
+		float xa_floor = floor( xa );
+		int ia = int( xa_floor );
+		float xb_ceil = ceil( xb );
+		int ib = int( xb_ceil );
+		_min_x[y] = std::min( _min_x[y], ia );
+
+		if ( ib <= ia + 1 )
+		{
+			float xm = 0.5F * ( x + xnext ) - xa_floor;
+			acc[ia] += d - d * xm;
+			acc[ia + 1] += d * xm;
+			_max_x[y] = std::max( _max_x[y], ia + 1 );
+		}
+		else
+		{
+			float s = 1.F / ( xb - xa );
+			float fa = xa - xa_floor;
+			float a0 = 0.5F * s * ( 1.F - fa ) * ( 1.F - fa );
+			float fb = xb - xb_ceil + 1.F;
+			float am = 0.5F * s * fb * fb;
+			acc[ia] += d * a0;
+			if ( ib == ia + 2 )
+				acc[ia + 1] += d * ( 1.F - a0 - am );
+			else
+			{
+				float a1 = s * ( 1.5F - fa );
+				acc[ia + 1] += d * ( a1 - a0 );
+				for ( int i = ia + 2; i < ib - 1; ++i )
+					acc[i] += d * s;
+				float a2 = a1 + float( ib - ia - 3 ) * s;
+				acc[ib - 1] += d * ( 1.F - a2 - am );
+			}
+			acc[ib] += d * am;
+			_max_x[y] = std::max( _max_x[y], ib );
+		}
+		x = xnext;
+	}
+}
+
+////////////////////////////////////////
+
+void rasterizer::polygon( const raster_point *p, size_t n )
+{
+	for ( size_t i = 0; i < n; ++i )
+	{
+		const raster_point &a = p[i];
+		const raster_point &b = p[( i + 1 ) % n];
+		line( a.x, a.y, b.x, b.y );
+	}
+}
+
+////////////////////////////////////////
+
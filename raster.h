@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+////////////////////////////////////////
+
+struct raster_point
+{
+	float x, y;
+};
+
+// The outline of a polyline stroked half_width to either side, as one
+// quad per segment (four points each) appended to quads.  Segments are
+// lengthened by half_width where they join another, which squares off
+// right-angled corners; the ends of an open polyline are cut flat.
+// All quads are wound the same way.
+void stroke_quads( vector<raster_point> &quads, const raster_point *p, size_t n, float half_width, bool closed );
+
+////////////////////////////////////////
+
+// Anti-aliased polygon filling over a band of rows, by exact area
+// coverage.  Edges of one shape are added with line(), then sweep()
+// turns the accumulated coverage into spans and clears it for the next
+// shape.  Winding is non-zero with the coverage clamped to one, so a
+// shape may be a union of overlapping polygons wound the same way, and
+// holes are polygons wound the other way.
+class rasterizer
+{
+public:
+	// The band covers rows [top, top + rows) and columns [0, width).
+	rasterizer( int width, int top, int rows );
+
+	// Moves the band; its coverage must have been swept.
+	void set_top( int top ) { _top = top; }
+
+	void line( float x0, float y0, float x1, float y1 );
+	void polygon( const raster_point *p, size_t n );
+
+	// Calls span( x, y, n, coverage ) for each run of pixels with the
+	// same coverage, row by row (y relative to the band).
+	template <class Span> void sweep( Span &span );
+
+private:
+	int _width;
+	int _top;
+	int _rows;
+	vector<float> _acc;
+	vector<int> _min_x;
+	vector<int> _max_x;
+
+	// Rows with coverage.
+	int _first;
+	int _last;
+};
+
+////////////////////////////////////////
+
+template <class Span>
+void rasterizer::sweep( Span &span )
+{
+	int first = _first, last_row = _last;
+	_first = _rows;
+	_last = -1;
+	for ( int y = first; y <= last_row; ++y )
+	{
+		int x = _min_x[y];
+		int last = _max_x[y];
+		if ( x > last )
+			continue;
+		_min_x[y] = _width + 2;
+		_max_x[y] = -1;
+
+		float *acc = &_acc[size_t( y ) * size_t( _width + 2 )];
+		float sum = 0.F;
+		while ( x <= last )
+		{
+			sum += acc[x];
+			acc[x] = 0.F;
+			int e = x + 1;
+			while ( e <= last && acc[e] == 0.F )
+				++e;
+			float c = std::min( fabs( sum ), 1.F );
+			if ( c > 1.F/512.F && x < _width )
+				span( x, y, std::min( e, _width ) - x, c );
+			x = e;
+		}
+	}
+}
+
+////////////////////////////////////////
+
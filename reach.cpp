@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "reach.h"
+#include "xref.h"
+#include "node.h"
+
+////////////////////////////////////////
+
+graph_components strong_components( size_t n, const vector<int> &roots, const function<void( int v, vector<int> &out )> &succ )
+{
+	vector<int> index( n, -1 );
+	vector<int> low( n, 0 );
+	vector<bool> on_stack( n, false );
+	vector<vector<int>> next( n );
+	vector<int> stack;
+	int visited = 0;
+
+	// The depth first search, as the vertex and how many of its
+	// successors have been followed.
+	vector<pair<int,size_t>> calls;
+	auto visit = [&]( int v )
+	{
+		index[size_t( v )] = low[size_t( v )] = visited++;
+		stack.push_back( v );
+		on_stack[size_t( v )] = true;
+		succ( v, next[size_t( v )] );
+		calls.push_back( make_pair( v, size_t( 0 ) ) );
+	};
+
+	graph_components ret;
+	for ( size_t r = 0; r < roots.size(); ++r )
+	{
+		if ( index[size_t( roots[r] )] < 0 )
+			visit( roots[r] );
+
+		while ( !calls.empty() )
+		{
+			int v = calls.back().first;
+			const vector<int> &out = next[size_t( v )];
+			if ( calls.back().second < out.size() )
+			{
+				int w = out[calls.back().second++];
+				if ( index[size_t( w )] < 0 )
+					visit( w );
+				else if ( on_stack[size_t( w )] )
+					low[size_t( v )] = std::min( low[size_t( v )], index[size_t( w )] );
+				continue;
+			}
+
+			calls.pop_back();
+			if ( !calls.empty() )
+			{
+				int u = calls.back().first;
+				low[size_t( u )] = std::min( low[size_t( u )], low[size_t( v )] );
+			}
+
+			if ( low[size_t( v )] == index[size_t( v )] )
+			{
+				vector<int> scc;
+				int w;
+				do
+				{
+					w = stack.back();
+					stack.pop_back();
+					on_stack[size_t( w )] = false;
+					scc.push_back( w );
+				} while ( w != v );
+
+				ret.cyclic.push_back( scc.size() > 1 || find( out.begin(), out.end(), v ) != out.end() );
+				sort( scc.begin(), scc.end() );
+				ret.list.push_back( scc );
+			}
+		}
+	}
+	return ret;
+}
+
+////////////////////////////////////////
+
+reach_result reachable( const node *gram, const string &root )
+{
+	const grammar *g = dynamic_cast<const grammar*>( gram );
+	vector<const production *> prods = grammar_productions( gram );
+
+	// The productions of every name (more than one if it is defined
+	// twice).
+	symbol_table names;
+	vector<vector<int>> defs;
+	for ( size_t i = 0; i < prods.size(); ++i )
+	{
+		const literal *id = dynamic_cast<const literal*>( prods[i]->id() );
+		int sym = names.intern( id ? id->value() : string() );
+		if ( size_t( sym ) >= defs.size() )
+			defs.resize( names.size() );
+		defs[size_t( sym )].push_back( int( i ) );
+	}
+
+	int start = names.find( root );
+	if ( start < 0 )
+		throw runtime_error( "no production named " + root );
+
+	const vector<int> &roots = defs[size_t( start )];
+	graph_components sccs = strong_components( prods.size(), roots, [&]( int v, vector<int> &out )
+	{
+		each_nonterminal( prods[size_t( v )]->expr(), [&]( const string &name )
+		{
+			int sym = names.find( name );
+			if ( sym >= 0 )
+				out.insert( out.end(), defs[size_t( sym )].begin(), defs[size_t( sym )].end() );
+		} );
+	} );
+
+	reach_result ret;
+	for ( size_t i = 0; i < sccs.cyclic.size(); ++i )
+	{
+		if ( sccs.cyclic[i] )
+			++ret.cycles;
+	}
+
+	// Components come out after every component they lead to.  The
+	// root goes before the rest of its own.
+	productions *list = new productions();
+	for ( size_t i = sccs.list.size(); i-- > 0; )
+	{
+		vector<int> &scc = sccs.list[i];
+		stable_partition( scc.begin(), scc.end(), [&]( int v ) { return v == roots[0]; } );
+		for ( size_t j = 0; j < scc.size(); ++j )
+			list->push_back( const_cast<production *>( prods[size_t( scc[j] )] ) );
+	}
+	ret.gram = new grammar( const_cast<node *>( g->title() ), list );
+
+	vector<bool> reached( prods.size(), false );
+	for ( size_t i = 0; i < sccs.list.size(); ++i )
+	{
+		for ( size_t j = 0; j < sccs.list[i].size(); ++j )
+			reached[size_t( sccs.list[i][j] )] = true;
+	}
+	for ( size_t i = 0; i < prods.size(); ++i )
+	{
+		if ( !reached[i] )
+			ret.unreachable.push_back( prods[i] );
+	}
+	return ret;
+}
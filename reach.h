@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class node;
+class production;
+
+using namespace std;
+
+////////////////////////////////////////
+
+struct graph_components
+{
+	// Each sorted, and after every component it leads to.
+	vector<vector<int>> list;
+
+	// Whether each is a cycle: more than one vertex, or one vertex that
+	// leads to itself.
+	vector<bool> cyclic;
+};
+
+// The strongly connected components of the graph of vertices 0 to n-1
+// that the roots lead to, found with Tarjan's algorithm but without
+// recursion.  succ() adds the successors of a vertex to out; it is
+// called once for every vertex reached.
+graph_components strong_components( size_t n, const vector<int> &roots, const function<void( int v, vector<int> &out )> &succ );
+
+////////////////////////////////////////
+
+struct reach_result
+{
+	reach_result( void )
+		: gram( NULL ), cycles( 0 )
+	{
+	}
+
+	// The grammar with only the productions reachable from the root:
+	// the root first, then every production before the ones it uses.
+	// Mutually recursive productions stay in grammar order, after the
+	// root if it is one of them.
+	node *gram;
+
+	// The productions left out, in grammar order.
+	vector<const production *> unreachable;
+
+	// How many groups of productions are (mutually) recursive.
+	size_t cycles;
+};
+
+////////////////////////////////////////
+
+// Follows the nonterminals from the production named root, and only
+// from the productions reached, finding their strongly connected
+// components as it goes.  Only the reachable part of the grammar is
+// ever walked, apart from a table of the production names.  Throws if
+// there is no production root.
+reach_result reachable( const node *gram, const string &root );
@@ -0,0 +1,834 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "record.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+const char magic[4] = { 'D', 'G', 'L', '1' };
+
+enum
+{
+	OP_BEGIN = 1,
+	OP_END,
+	OP_PUSH_TRANSLATE,
+	OP_POP_TRANSLATE,
+	OP_ID_BEGIN,
+	OP_ID_END,
+	OP_LINK_BEGIN,
+	OP_LINK_END,
+	OP_CIRCLE,
+	OP_BOX,
+	OP_ROUND,
+	OP_TEXT,
+	OP_TEXT_CENTER,
+	OP_HLINE,
+	OP_VLINE,
+	OP_PATH_ARC,
+	OP_PATH_DIR,
+	OP_ARROW_LEFT,
+	OP_ARROW_RIGHT,
+	OP_ARROW_DOWN,
+	OP_ARROW_HEAD,
+	OP_PATH_BEGIN,
+	OP_PATH_MOVE,
+	OP_PATH_H_BY,
+	OP_PATH_V_BY,
+	OP_PATH_H_TO,
+	OP_PATH_V_TO,
+	OP_PATH_TO,
+	OP_ARC,
+	OP_PATH_ARROW_LEFT,
+	OP_PATH_ARROW_RIGHT,
+	OP_PATH_ARROW_DOWN,
+	OP_PATH_END,
+	OP_GROUP_BEGIN,
+	OP_GROUP_END,
+	OP_PART_BEGIN,
+	OP_PART_END
+};
+
+struct reader
+{
+	reader( const char *d, size_t n )
+		: p( d ), end( d + n )
+	{
+	}
+
+	void need( size_t n )
+	{
+		if ( size_t( end - p ) < n )
+			throw runtime_error( "truncated display list" );
+	}
+
+	int code( void )
+	{
+		need( 1 );
+		return static_cast<unsigned char>( *p++ );
+	}
+
+	float f( void )
+	{
+		float v;
+		need( sizeof( v ) );
+		memcpy( &v, p, sizeof( v ) );
+		p += sizeof( v );
+		return v;
+	}
+
+	point pt( void )
+	{
+		float x = f();
+		float y = f();
+		return point( x, y );
+	}
+
+	string s( void )
+	{
+		uint32_t n;
+		need( sizeof( n ) );
+		memcpy( &n, p, sizeof( n ) );
+		p += sizeof( n );
+		need( n );
+		string ret( p, n );
+		p += n;
+		return ret;
+	}
+
+	const char *p;
+	const char *end;
+};
+
+////////////////////////////////////////
+
+// Swallows the calls of a group that the target placed as a copy.
+class draw_skip : public draw
+{
+public:
+	draw_skip( buffer &o ) : draw( o ) {}
+
+	virtual void begin( const string & ) {}
+	virtual void end( void ) {}
+	virtual void id_begin( float, float, float, float, const string & ) {}
+	virtual void id_end() {}
+	virtual void link_begin( const string & ) {}
+	virtual void link_end() {}
+	virtual void circle( float, float, float, Class ) {}
+	virtual void box( float, float, float, float, Class ) {}
+	virtual void round( float, float, float, float, Class ) {}
+	virtual void text( float, float, float, float, const string &, Class ) {}
+	virtual void text_center( float, float, float, float, const string &, Class ) {}
+	virtual void path_begin( float, float, Class ) {}
+	virtual void path_move( float, float ) {}
+	virtual void path_h_by( float ) {}
+	virtual void path_v_by( float ) {}
+	virtual void path_h_to( float ) {}
+	virtual void path_v_to( float ) {}
+	virtual void path_to( float, float ) {}
+	virtual void path_arc( float, Arc ) {}
+	virtual void path_arrow_left( float ) {}
+	virtual void path_arrow_right( float ) {}
+	virtual void path_arrow_down( float ) {}
+	virtual void path_end( void ) {}
+};
+
+}
+
+////////////////////////////////////////
+
+draw_record::draw_record( buffer &o )
+	: draw( o )
+{
+	out.append( magic, sizeof( magic ) );
+}
+
+////////////////////////////////////////
+
+draw_record::~draw_record( void )
+{
+}
+
+////////////////////////////////////////
+
+void draw_record::begin( const string &title )
+{
+	op( OP_BEGIN );
+	put( title );
+}
+
+////////////////////////////////////////
+
+void draw_record::end( void )
+{
+	op( OP_END );
+}
+
+////////////////////////////////////////
+
+void draw_record::push_translate( const point &p )
+{
+	op( OP_PUSH_TRANSLATE );
+	put( p );
+}
+
+////////////////////////////////////////
+
+void draw_record::pop_translate( void )
+{
+	op( OP_POP_TRANSLATE );
+}
+
+////////////////////////////////////////
+
+void draw_record::id_begin( float x, float y, float w, float h, const string &name )
+{
+	op( OP_ID_BEGIN );
+	put( x ); put( y ); put( w ); put( h );
+	put( name );
+}
+
+////////////////////////////////////////
+
+void draw_record::id_end( void )
+{
+	op( OP_ID_END );
+}
+
+////////////////////////////////////////
+
+void draw_record::part_begin( float x, float y, float w, float h, const string &name )
+{
+	op( OP_PART_BEGIN );
+	put( x ); put( y ); put( w ); put( h );
+	put( name );
+}
+
+////////////////////////////////////////
+
+void draw_record::part_end( void )
+{
+	op( OP_PART_END );
+}
+
+////////////////////////////////////////
+
+void draw_record::link_begin( const string &name )
+{
+	op( OP_LINK_BEGIN );
+	put( name );
+}
+
+////////////////////////////////////////
+
+void draw_record::link_end( void )
+{
+	op( OP_LINK_END );
+}
+
+////////////////////////////////////////
+
+void draw_record::circle( float x, float y, float r, Class cl )
+{
+	op( OP_CIRCLE );
+	put( x ); put( y ); put( r );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::box( float x, float y, float w, float h, Class cl )
+{
+	op( OP_BOX );
+	put( x ); put( y ); put( w ); put( h );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::round( float x, float y, float w, float h, Class cl )
+{
+	op( OP_ROUND );
+	put( x ); put( y ); put( w ); put( h );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::text( float x, float y, float w, float h, const string &text, Class cl )
+{
+	op( OP_TEXT );
+	put( x ); put( y ); put( w ); put( h );
+	put( text );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::text_center( float x, float y, float w, float h, const string &text, Class cl )
+{
+	op( OP_TEXT_CENTER );
+	put( x ); put( y ); put( w ); put( h );
+	put( text );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::hline( const point &p1, const point &p2, Class cl )
+{
+	op( OP_HLINE );
+	put( p1 ); put( p2 );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::vline( const point &p1, const point &p2, Class cl )
+{
+	op( OP_VLINE );
+	put( p1 ); put( p2 );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::path( const point &p1, const point &p2, float r, Arc dir, Class cl )
+{
+	op( OP_PATH_ARC );
+	put( p1 ); put( p2 ); put( r );
+	put( dir );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::path( Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl )
+{
+	op( OP_PATH_DIR );
+	put( d1 );
+	put( p1 ); put( p2 );
+	put( d2 );
+	put( r );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::arrow_left( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	op( OP_ARROW_LEFT );
+	put( p ); put( l ); put( size );
+	put( cl1 ); put( cl2 );
+}
+
+////////////////////////////////////////
+
+void draw_record::arrow_right( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	op( OP_ARROW_RIGHT );
+	put( p ); put( l ); put( size );
+	put( cl1 ); put( cl2 );
+}
+
+////////////////////////////////////////
+
+void draw_record::arrow_down( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	op( OP_ARROW_DOWN );
+	put( p ); put( l ); put( size );
+	put( cl1 ); put( cl2 );
+}
+
+////////////////////////////////////////
+
+void draw_record::arrow_head( float x, float y, Direction d, float size, Class cl )
+{
+	op( OP_ARROW_HEAD );
+	put( x ); put( y );
+	put( d );
+	put( size );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_begin( float x, float y, Class cl )
+{
+	op( OP_PATH_BEGIN );
+	put( x ); put( y );
+	put( cl );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_move( float x, float y )
+{
+	op( OP_PATH_MOVE );
+	put( x ); put( y );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_h_by( float x )
+{
+	op( OP_PATH_H_BY );
+	put( x );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_v_by( float y )
+{
+	op( OP_PATH_V_BY );
+	put( y );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_h_to( float x )
+{
+	op( OP_PATH_H_TO );
+	put( x );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_v_to( float y )
+{
+	op( OP_PATH_V_TO );
+	put( y );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_to( float x, float y )
+{
+	op( OP_PATH_TO );
+	put( x ); put( y );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_arc( float r, Arc a )
+{
+	op( OP_ARC );
+	put( r );
+	put( a );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_arrow_left( float size )
+{
+	op( OP_PATH_ARROW_LEFT );
+	put( size );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_arrow_right( float size )
+{
+	op( OP_PATH_ARROW_RIGHT );
+	put( size );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_arrow_down( float size )
+{
+	op( OP_PATH_ARROW_DOWN );
+	put( size );
+}
+
+////////////////////////////////////////
+
+void draw_record::path_end( void )
+{
+	op( OP_PATH_END );
+}
+
+////////////////////////////////////////
+
+bool draw_record::reuses_groups( void ) const
+{
+	return true;
+}
+
+////////////////////////////////////////
+
+// Groups are always drawn into the list; the target of a replay
+// decides whether to draw them again.
+bool draw_record::group_begin( const string &key, float x, float y )
+{
+	op( OP_GROUP_BEGIN );
+	put( key );
+	put( x );
+	put( y );
+	return false;
+}
+
+////////////////////////////////////////
+
+void draw_record::group_end( void )
+{
+	op( OP_GROUP_END );
+}
+
+////////////////////////////////////////
+
+void draw_record::op( int code )
+{
+	out.append( char( code ) );
+}
+
+////////////////////////////////////////
+
+void draw_record::put( float v )
+{
+	out.append( reinterpret_cast<const char *>( &v ), sizeof( v ) );
+}
+
+////////////////////////////////////////
+
+void draw_record::put( const point &p )
+{
+	put( p.x );
+	put( p.y );
+}
+
+////////////////////////////////////////
+
+// Enumerations (Class, Arc, Direction) all fit in a byte.
+void draw_record::put( int e )
+{
+	out.append( char( e ) );
+}
+
+////////////////////////////////////////
+
+void draw_record::put( const string &s )
+{
+	uint32_t n = uint32_t( s.size() );
+	out.append( reinterpret_cast<const char *>( &n ), sizeof( n ) );
+	out.append( s.data(), s.size() );
+}
+
+////////////////////////////////////////
+
+display_list::display_list( const string &filename )
+	: _data( NULL ), _size( 0 )
+{
+	int fd = open( filename.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		throw runtime_error( "could not open display list " + filename );
+
+	struct stat st;
+	if ( fstat( fd, &st ) < 0 )
+	{
+		close( fd );
+		throw runtime_error( "could not stat display list " + filename );
+	}
+
+	_size = size_t( st.st_size );
+	if ( _size > 0 )
+	{
+		void *p = mmap( NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( p == MAP_FAILED )
+		{
+			close( fd );
+			throw runtime_error( "could not map display list " + filename );
+		}
+		_data = static_cast<const char *>( p );
+	}
+	close( fd );
+}
+
+////////////////////////////////////////
+
+display_list::~display_list( void )
+{
+	if ( _data )
+		munmap( const_cast<char *>( _data ), _size );
+}
+
+////////////////////////////////////////
+
+void replay( draw &dc, const char *data, size_t size )
+{
+	if ( size < sizeof( magic ) || memcmp( data, magic, sizeof( magic ) ) != 0 )
+		throw runtime_error( "not a display list" );
+
+	reader r( data + sizeof( magic ), size - sizeof( magic ) );
+
+	// Calls go to t, which is a draw_skip while inside a group that dc
+	// placed as a copy (skipping counts the nesting).
+	buffer scratch;
+	draw_skip skip( scratch );
+	draw *t = &dc;
+	int skipping = 0;
+	while ( r.p != r.end )
+	{
+		int code = r.code();
+		switch ( code )
+		{
+			case OP_BEGIN:
+			{
+				string title = r.s();
+				t->begin( title );
+				break;
+			}
+
+			case OP_END:
+				t->end();
+				break;
+
+			case OP_PUSH_TRANSLATE:
+			{
+				point p = r.pt();
+				t->push_translate( p );
+				break;
+			}
+
+			case OP_POP_TRANSLATE:
+				t->pop_translate();
+				break;
+
+			case OP_ID_BEGIN:
+			{
+				float x = r.f(), y = r.f(), w = r.f(), h = r.f();
+				string name = r.s();
+				t->id_begin( x, y, w, h, name );
+				break;
+			}
+
+			case OP_ID_END:
+				t->id_end();
+				break;
+
+			case OP_PART_BEGIN:
+			{
+				float x = r.f(), y = r.f(), w = r.f(), h = r.f();
+				string name = r.s();
+				t->part_begin( x, y, w, h, name );
+				break;
+			}
+
+			case OP_PART_END:
+				t->part_end();
+				break;
+
+			case OP_LINK_BEGIN:
+			{
+				string name = r.s();
+				t->link_begin( name );
+				break;
+			}
+
+			case OP_LINK_END:
+				t->link_end();
+				break;
+
+			case OP_CIRCLE:
+			{
+				float x = r.f(), y = r.f(), rad = r.f();
+				Class cl = Class( r.code() );
+				t->circle( x, y, rad, cl );
+				break;
+			}
+
+			case OP_BOX:
+			case OP_ROUND:
+			{
+				float x = r.f(), y = r.f(), w = r.f(), h = r.f();
+				Class cl = Class( r.code() );
+				if ( code == OP_BOX )
+					t->box( x, y, w, h, cl );
+				else
+					t->round( x, y, w, h, cl );
+				break;
+			}
+
+			case OP_TEXT:
+			case OP_TEXT_CENTER:
+			{
+				float x = r.f(), y = r.f(), w = r.f(), h = r.f();
+				string text = r.s();
+				Class cl = Class( r.code() );
+				if ( code == OP_TEXT )
+					t->text( x, y, w, h, text, cl );
+				else
+					t->text_center( x, y, w, h, text, cl );
+				break;
+			}
+
+			case OP_HLINE:
+			case OP_VLINE:
+			{
+				point p1 = r.pt();
+				point p2 = r.pt();
+				Class cl = Class( r.code() );
+				if ( code == OP_HLINE )
+					t->hline( p1, p2, cl );
+				else
+					t->vline( p1, p2, cl );
+				break;
+			}
+
+			case OP_PATH_ARC:
+			{
+				point p1 = r.pt();
+				point p2 = r.pt();
+				float rad = r.f();
+				Arc dir = Arc( r.code() );
+				Class cl = Class( r.code() );
+				t->path( p1, p2, rad, dir, cl );
+				break;
+			}
+
+			case OP_PATH_DIR:
+			{
+				Direction d1 = Direction( r.code() );
+				point p1 = r.pt();
+				point p2 = r.pt();
+				Direction d2 = Direction( r.code() );
+				float rad = r.f();
+				Class cl = Class( r.code() );
+				t->path( d1, p1, p2, d2, rad, cl );
+				break;
+			}
+
+			case OP_ARROW_LEFT:
+			case OP_ARROW_RIGHT:
+			case OP_ARROW_DOWN:
+			{
+				point p = r.pt();
+				float l = r.f(), size = r.f();
+				Class cl1 = Class( r.code() );
+				Class cl2 = Class( r.code() );
+				if ( code == OP_ARROW_LEFT )
+					t->arrow_left( p, l, size, cl1, cl2 );
+				else if ( code == OP_ARROW_RIGHT )
+					t->arrow_right( p, l, size, cl1, cl2 );
+				else
+					t->arrow_down( p, l, size, cl1, cl2 );
+				break;
+			}
+
+			case OP_ARROW_HEAD:
+			{
+				float x = r.f(), y = r.f();
+				Direction d = Direction( r.code() );
+				float size = r.f();
+				Class cl = Class( r.code() );
+				t->arrow_head( x, y, d, size, cl );
+				break;
+			}
+
+			case OP_PATH_BEGIN:
+			{
+				float x = r.f(), y = r.f();
+				Class cl = Class( r.code() );
+				t->path_begin( x, y, cl );
+				break;
+			}
+
+			case OP_PATH_MOVE:
+			{
+				float x = r.f(), y = r.f();
+				t->path_move( x, y );
+				break;
+			}
+
+			case OP_PATH_H_BY: t->path_h_by( r.f() ); break;
+			case OP_PATH_V_BY: t->path_v_by( r.f() ); break;
+			case OP_PATH_H_TO: t->path_h_to( r.f() ); break;
+			case OP_PATH_V_TO: t->path_v_to( r.f() ); break;
+
+			case OP_PATH_TO:
+			{
+				float x = r.f(), y = r.f();
+				t->path_to( x, y );
+				break;
+			}
+
+			case OP_ARC:
+			{
+				float rad = r.f();
+				Arc a = Arc( r.code() );
+				t->path_arc( rad, a );
+				break;
+			}
+
+			case OP_PATH_ARROW_LEFT: t->path_arrow_left( r.f() ); break;
+			case OP_PATH_ARROW_RIGHT: t->path_arrow_right( r.f() ); break;
+			case OP_PATH_ARROW_DOWN: t->path_arrow_down( r.f() ); break;
+
+			case OP_PATH_END:
+				t->path_end();
+				break;
+
+			case OP_GROUP_BEGIN:
+			{
+				string key = r.s();
+				float x = r.f(), y = r.f();
+				if ( skipping > 0 )
+					++skipping;
+				else if ( dc.group_begin( key, x, y ) )
+				{
+					skipping = 1;
+					t = &skip;
+				}
+				break;
+			}
+
+			case OP_GROUP_END:
+				if ( skipping > 0 )
+				{
+					if ( --skipping == 0 )
+						t = &dc;
+				}
+				else
+					dc.group_end();
+				break;
+
+			default:
+				throw runtime_error( "corrupt display list" );
+		}
+	}
+}
+
+////////////////////////////////////////
+
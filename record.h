@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <string>
+
+#include "draw.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+// Records every draw call into a compact binary display list in the
+// given buffer.  The list can be replayed into any other draw object,
+// as many times as needed, or written to disk and mapped back later.
+class draw_record : public draw
+{
+public:
+	draw_record( buffer &o );
+	virtual ~draw_record( void );
+
+	virtual void begin( const string &title );
+	virtual void end( void );
+
+	virtual void push_translate( const point &p );
+	virtual void pop_translate( void );
+
+	virtual void id_begin( float x, float y, float w, float h, const string &name );
+	virtual void id_end();
+
+	virtual void link_begin( const string &name );
+	virtual void link_end();
+
+	virtual void part_begin( float x, float y, float w, float h, const string &name );
+	virtual void part_end( void );
+
+	virtual void circle( float x, float y, float r, Class cl );
+	virtual void box( float x, float y, float w, float h, Class cl );
+	virtual void round( float x, float y, float w, float h, Class c );
+	virtual void text( float x, float y, float w, float h, const string &text, Class cl );
+	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl );
+
+	virtual void hline( const point &p1, const point &p2, Class cl );
+	virtual void vline( const point &p1, const point &p2, Class cl );
+
+	virtual void path( const point &p1, const point &p2, float r, Arc dir, Class cl );
+	virtual void path( Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl );
+
+	virtual void arrow_left( const point &p, float l, float size, Class cl1, Class cl2 );
+	virtual void arrow_right( const point &p, float l, float size, Class cl1, Class cl2 );
+	virtual void arrow_down( const point &p, float l, float size, Class cl1, Class cl2 );
+	virtual void arrow_head( float x, float y, Direction d, float size, Class cl );
+
+	virtual bool reuses_groups( void ) const;
+	virtual bool group_begin( const string &key, float x, float y );
+	virtual void group_end( void );
+
+	virtual void path_begin( float x, float y, Class cl );
+	virtual void path_move( float x, float y );
+
+	virtual void path_h_by( float x );
+	virtual void path_v_by( float y );
+	virtual void path_h_to( float x );
+	virtual void path_v_to( float y );
+	virtual void path_to( float x, float y );
+	virtual void path_arc( float r, Arc a );
+	virtual void path_arrow_left( float size );
+	virtual void path_arrow_right( float size );
+	virtual void path_arrow_down( float size );
+
+	virtual void path_end( void );
+
+private:
+	void op( int code );
+	void put( float v );
+	void put( const point &p );
+	void put( int e );
+	void put( const string &s );
+};
+
+////////////////////////////////////////
+
+// A display list file mapped read-only into memory.
+class display_list
+{
+public:
+	display_list( const string &filename );
+	~display_list( void );
+
+	inline const char *data( void ) const { return _data; }
+	inline size_t size( void ) const { return _size; }
+
+private:
+	display_list( const display_list & );
+	display_list &operator=( const display_list & );
+
+	const char *_data;
+	size_t _size;
+};
+
+////////////////////////////////////////
+
+void replay( draw &dc, const char *data, size_t size );
+
+inline void replay( draw &dc, const buffer &b )
+{
+	replay( dc, b.data(), b.size() );
+}
+
+inline void replay( draw &dc, const display_list &l )
+{
+	replay( dc, l.data(), l.size() );
+}
+
+////////////////////////////////////////
+
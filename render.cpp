@@ -25,10 +25,12 @@
 #include <stdexcept>
 
 #include "svg.h"
+#include "tikz.h"
 #include "node.h"
 #include "print.h"
 #include "render.h"
 #include "draw.h"
+#include "xref.h"
 
 #define TEXT_SIZE 24.F
 #define TEXT_PAD 8.F
@@ -42,6 +44,10 @@
 
 ////////////////////////////////////////
 
+const char *const title_part = "_top";
+
+////////////////////////////////////////
+
 render_box &
 compute_size( render_context &ctxt, const node *node, bool &above )
 {
@@ -363,11 +369,131 @@ compute_size( render_context &ctxt, const node *node, bool &above )
 
 ////////////////////////////////////////
 
-void render( draw &dc, const node *node, render_context &ctxt, bool &above )
+// The name of a production, as used for its anchor.
+string part_name( const node *n )
+{
+	if ( const production *p = dynamic_cast<const production*>( n ) )
+	{
+		if ( const literal *l = dynamic_cast<const literal*>( p->id() ) )
+			return l->value();
+	}
+	return string();
+}
+
+////////////////////////////////////////
+
+// Keys for shapes and groups are built from the raw bytes of numbers.
+template <typename T>
+void append_raw( string &s, const T &v )
+{
+	s.append( reinterpret_cast<const char *>( &v ), sizeof( v ) );
+}
+
+////////////////////////////////////////
+
+// Give every subtree below the productions a shape number: subtrees
+// with the same structure get the same number.  The walk only offers
+// shapes that occur more than once to the backend as groups.
+int count_shapes( render_context &ctxt, const node *node )
+{
+	string desc;
+	if ( const grammar *n = dynamic_cast<const grammar*>( node ) )
+	{
+		count_shapes( ctxt, n->prods() );
+		return -1;
+	}
+	else if ( const productions *n = dynamic_cast<const productions*>( node ) )
+	{
+		for ( size_t i = 0; i < n->size(); ++i )
+			count_shapes( ctxt, n->at( i ) );
+		return -1;
+	}
+	else if ( const production *n = dynamic_cast<const production*>( node ) )
+	{
+		count_shapes( ctxt, n->expr() );
+		return -1;
+	}
+	else if ( const expression *n = dynamic_cast<const expression*>( node ) )
+	{
+		desc += n->is_short() ? 's' : '|';
+		for ( size_t i = 0; i < n->size(); ++i )
+			append_raw( desc, count_shapes( ctxt, n->at( i ) ) );
+	}
+	else if ( const term *n = dynamic_cast<const term*>( node ) )
+	{
+		desc += '&';
+		for ( size_t i = 0; i < n->size(); ++i )
+			append_raw( desc, count_shapes( ctxt, n->at( i ) ) );
+	}
+	else if ( const repetition *n = dynamic_cast<const repetition*>( node ) )
+	{
+		desc += '{';
+		append_raw( desc, count_shapes( ctxt, n->expr() ) );
+	}
+	else if ( const onemore *n = dynamic_cast<const onemore*>( node ) )
+	{
+		desc += '<';
+		append_raw( desc, count_shapes( ctxt, n->expr() ) );
+		if ( n->sep() )
+			append_raw( desc, count_shapes( ctxt, n->sep() ) );
+	}
+	else if ( const optional *n = dynamic_cast<const optional*>( node ) )
+	{
+		desc += '[';
+		append_raw( desc, count_shapes( ctxt, n->expr() ) );
+	}
+	else if ( const literal *n = dynamic_cast<const literal*>( node ) )
+	{
+		desc += '"';
+		desc += n->quote();
+		desc += n->value();
+	}
+	else
+		return -1;
+
+	int next = int( ctxt.shape_count.size() );
+	int id = ctxt.shape_ids.insert( make_pair( desc, next ) ).first->second;
+	if ( id == next )
+		ctxt.shape_count.push_back( 0 );
+	++ctxt.shape_count[id];
+	ctxt.data[node].set_shape( id );
+	return id;
+}
+
+////////////////////////////////////////
+
+// The walk is a template over the backend so that the built-in backends
+// get their primitives bound statically; render( draw & ) keeps the
+// virtual interface for everything else.
+template <class DC>
+void render( DC &dc, const node *node, render_context &ctxt, bool &above )
 {
 	render_box &self = ctxt.data[node];
 	ctxt.push_state();
 
+	// A repeated subtree drawn in the same direction, and not attached
+	// to rails outside of it, always looks the same.  Backends may then
+	// place a copy of the first one instead of drawing it again.
+	string group;
+	if ( ctxt.dir != NONE && !ctxt.use_left_rail && !ctxt.use_right_rail )
+	{
+		int shape = self.shape();
+		if ( shape >= 0 && ctxt.shape_count[shape] > 1 )
+		{
+			append_raw( group, shape );
+			append_raw( group, ctxt.dir );
+			append_raw( group, above );
+			append_raw( group, self.width() );
+			append_raw( group, self.height() );
+			if ( dc.group_begin( group, self.x(), self.y() ) )
+			{
+				above = ctxt.groups[group];
+				ctxt.pop_state();
+				return;
+			}
+		}
+	}
+
 	if ( const grammar *n = dynamic_cast<const grammar*>( node ) )
 	{
 		ctxt.dir = NONE;
@@ -375,8 +501,26 @@ void render( draw &dc, const node *node, render_context &ctxt, bool &above )
 		ctxt.push_state();
 		dc.push_translate( self.tl_corner() );
 		if( n->title() )
+		{
+			render_box &t = ctxt.data[n->title()];
+			dc.part_begin( t.x(), t.y(), t.width(), t.height(), title_part );
 			render( dc, n->title(), ctxt, above );
-		render( dc, n->prods(), ctxt, above );
+			dc.part_end();
+		}
+
+		// A grammar with a single production has no list of them, and
+		// that production is the only part.
+		if ( dynamic_cast<const production*>( n->prods() ) )
+		{
+			render_box &p = ctxt.data[n->prods()];
+			dc.part_begin( p.x(), p.y(), p.width(), p.height(), part_name( n->prods() ) );
+			ctxt.push_state();
+			render( dc, n->prods(), ctxt, above );
+			ctxt.pop_state();
+			dc.part_end();
+		}
+		else
+			render( dc, n->prods(), ctxt, above );
 		dc.pop_translate();
 		ctxt.pop_state();
 	}
@@ -387,9 +531,12 @@ void render( draw &dc, const node *node, render_context &ctxt, bool &above )
 		above = false;
 		for ( size_t i = 0; i < n->size(); ++i )
 		{
+			render_box &p = ctxt.data[n->at( i )];
+			dc.part_begin( p.x(), p.y(), p.width(), p.height(), part_name( n->at( i ) ) );
 			ctxt.push_state();
 			render( dc, n->at( i ), ctxt, above );
 			ctxt.pop_state();
+			dc.part_end();
 		}
 		dc.pop_translate();
 	}
@@ -831,9 +978,16 @@ void render( draw &dc, const node *node, render_context &ctxt, bool &above )
 				break;
 
 			case NONTERM:
+			{
+				bool link = ctxt.refs && ctxt.refs->is_defined( n->value() );
+				if ( link )
+					dc.link_begin( n->value() );
 				dc.box( p1.x, p1.y, p2.x-p1.x, p2.y-p1.y, cl );
 				dc.text_center( p1.x, p1.y, p2.x-p1.x, p2.y-p1.y, n->value(), cl );
+				if ( link )
+					dc.link_end();
 				break;
+			}
 
 			default:
 				dc.round( p1.x, p1.y, p2.x-p1.x, p2.y-p1.y, cl );
@@ -848,29 +1002,61 @@ void render( draw &dc, const node *node, render_context &ctxt, bool &above )
 		tmp << (void*)node << ' ' << *node;
 		throw runtime_error( string( "Unknown node type: " ) + tmp.str() );
 	}
+
+	if ( !group.empty() )
+	{
+		ctxt.groups[group] = above;
+		dc.group_end();
+	}
 	ctxt.pop_state();
 }
 
 ////////////////////////////////////////
 
-void render( draw &dc, const node *e )
+const grammar *grammar_of( const node *e )
 {
 	const grammar *n = dynamic_cast<const grammar*>( e );
 	if ( !n )
 		throw runtime_error( "invalid grammar node" );
+	return n;
+}
+
+////////////////////////////////////////
+
+string grammar_title( const node *gram )
+{
+	const grammar *n = grammar_of( gram );
+	const literal *l = dynamic_cast<const literal*>( n->title() );
+	return l ? l->value() : string( "Grammar" );
+}
+
+////////////////////////////////////////
+
+void layout( render_context &ctxt, const node *gram )
+{
+	bool above = false;
+	compute_size( ctxt, grammar_of( gram ), above );
+}
+
+////////////////////////////////////////
+
+template <class DC>
+void render_grammar( DC &dc, const node *e )
+{
+	const grammar *n = grammar_of( e );
 
 	render_context ctxt;
 	bool above = false;
 	compute_size( ctxt, n, above );
+	if ( dc.reuses_groups() )
+		count_shapes( ctxt, n );
+	xref refs( n );
+	ctxt.refs = &refs;
 
-	const literal *l = dynamic_cast<const literal*>( n->title() );
-	if ( l )
-		dc.begin( l->value() );
-	else
-		dc.begin( "Grammar" );
+	dc.begin( grammar_title( n ) );
 
 	render_box &top = ctxt.data[n];
-	dc.id_begin( top.x(), top.y(), top.width(), top.height(), "top" );
+	dc.id_begin( top.x(), top.y(), top.width(), top.height(), title_part );
 	render( dc, n, ctxt, above );
 	dc.id_end();
 
@@ -879,3 +1065,98 @@ void render( draw &dc, const node *e )
 
 ////////////////////////////////////////
 
+// One part as a document of its own, moved to the origin.
+template <class DC>
+void render_part( DC &dc, render_context &ctxt, const node *part, const string &title, const string &name )
+{
+	render_box &b = ctxt.data[part];
+	bool above = false;
+	ctxt.dir = NONE;
+	ctxt.use_left_rail = ctxt.use_right_rail = false;
+
+	dc.begin( title );
+	dc.id_begin( -b.x(), -b.y(), b.width(), b.height(), name );
+	dc.part_begin( b.x(), b.y(), b.width(), b.height(), name );
+	render( dc, part, ctxt, above );
+	dc.part_end();
+	dc.id_end();
+	dc.end();
+}
+
+////////////////////////////////////////
+
+void render( draw &dc, const node *gram )
+{
+	render_grammar( dc, gram );
+}
+
+////////////////////////////////////////
+
+void render( draw_svg &dc, const node *gram )
+{
+	render_grammar( dc, gram );
+}
+
+////////////////////////////////////////
+
+void render( draw_tikz &dc, const node *gram )
+{
+	render_grammar( dc, gram );
+}
+
+////////////////////////////////////////
+
+
+void render_parts( const node *gram, const function<draw &( const string &name, const part_box &box )> &begin, const function<void( const string &name )> &done )
+{
+	const grammar *n = grammar_of( gram );
+
+	render_context ctxt;
+	bool above = false;
+	compute_size( ctxt, n, above );
+	bool shapes = false;
+
+	string title = grammar_title( n );
+	render_box &top = ctxt.data[n];
+	vector<const node *> parts;
+	if ( n->title() )
+		parts.push_back( n->title() );
+	const productions *prods = dynamic_cast<const productions*>( n->prods() );
+	for ( size_t i = 0; prods && i < prods->size(); ++i )
+		parts.push_back( prods->at( i ) );
+	if ( dynamic_cast<const production*>( n->prods() ) )
+		parts.push_back( n->prods() );
+
+	for ( size_t i = 0; i < parts.size(); ++i )
+	{
+		// Productions are laid out relative to the list of them.
+		render_box &b = ctxt.data[parts[i]];
+		point at = top.tl_corner();
+		if ( parts[i] != n->title() && prods )
+			at = at.move( ctxt.data[prods].tl_corner() );
+
+		part_box box;
+		box.x = at.x + b.x();
+		box.y = at.y + b.y();
+		box.w = b.width();
+		box.h = b.height();
+
+		string name = parts[i] == n->title() ? string( title_part ) : part_name( parts[i] );
+		draw &dc = begin( name, box );
+		if ( !shapes && dc.reuses_groups() )
+		{
+			count_shapes( ctxt, n );
+			shapes = true;
+		}
+
+		if ( draw_svg *svg = dynamic_cast<draw_svg *>( &dc ) )
+			render_part( *svg, ctxt, parts[i], title, name );
+		else if ( draw_tikz *tikz = dynamic_cast<draw_tikz *>( &dc ) )
+			render_part( *tikz, ctxt, parts[i], title, name );
+		else
+			render_part( dc, ctxt, parts[i], title, name );
+		done( name );
+	}
+}
+
+////////////////////////////////////////
@@ -23,23 +23,29 @@
 #pragma once
 
 #include <cmath>
+#include <functional>
 #include <map>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include "draw.h"
 
 class node;
+class draw_svg;
+class draw_tikz;
+class xref;
 
 using namespace std;
 
 struct render_box
 {
 	render_box( void )
-		: _p1( 0, 0 ), _p2( 0, 0 ), _xanchor( 0 ), _yanchor( 0 )
+		: _p1( 0, 0 ), _p2( 0, 0 ), _xanchor( 0 ), _yanchor( 0 ), _shape( -1 )
 	{
 	}
 
 	render_box( float x, float y )
-		: _p1( x, y ), _p2( x, y ), _xanchor( 0 ), _yanchor( 0 )
+		: _p1( x, y ), _p2( x, y ), _xanchor( 0 ), _yanchor( 0 ), _shape( -1 )
 	{
 	}
 
@@ -139,21 +145,34 @@ struct render_box
 	float width( void ) const { return _p2.x - _p1.x; }
 	float height( void ) const { return _p2.y - _p1.y; }
 
+	int shape( void ) const { return _shape; }
+	void set_shape( int s ) { _shape = s; }
+
 private:
 	point _p1, _p2;
 	float _xanchor;
 	float _yanchor;
+	int _shape;
 };
 
 struct render_context
 {
 	render_context( void )
-		: dir( NONE ), use_left_rail( false ), use_right_rail( false )
+		: refs( NULL ), dir( NONE ), use_left_rail( false ), use_right_rail( false )
 	{
 	}
 
 	map<const node *,render_box> data;
 
+	// Repeated subtrees: shape numbers by description, how often each
+	// occurs, and the "above" flag each group drawn so far left behind.
+	unordered_map<string,int> shape_ids;
+	vector<int> shape_count;
+	unordered_map<string,bool> groups;
+
+	// Nonterminals defined in the grammar link to their production.
+	const xref *refs;
+
 	Direction dir;
 
 	bool use_left_rail;
@@ -211,3 +230,31 @@ private:
 
 void render( draw &dc, const node *gram );
 
+// Statically dispatched versions for the built-in backends.
+void render( draw_svg &dc, const node *gram );
+void render( draw_tikz &dc, const node *gram );
+
+// The title of a grammar, or "Grammar" when it has none.
+string grammar_title( const node *gram );
+
+// Lay out a grammar without drawing it: afterwards ctxt.data holds the
+// box of every node, relative to the top left corner of its parent's.
+void layout( render_context &ctxt, const node *gram );
+
+// Where a part of the grammar sits in the full layout.
+struct part_box
+{
+	float x, y, w, h;
+};
+
+// The name of the part (and the id) the title of a grammar is drawn
+// as.  It starts with '_', which identifiers in grammar.g cannot, so it
+// never clashes with a production.
+extern const char *const title_part;
+
+// Split output: the grammar is laid out once, then the title (named
+// title_part) and every production are drawn as documents of their own.
+// For each part, begin() returns the backend to draw it with, and
+// done() is called after the backend's end().
+void render_parts( const node *gram, const function<draw &( const string &name, const part_box &box )> &begin, const function<void( const string &name )> &done );
+
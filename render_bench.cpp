@@ -0,0 +1,194 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "html.h"
+#include "json.h"
+#include "node.h"
+#include "pdf.h"
+#include "png.h"
+#include "render.h"
+#include "svg.h"
+#include "tikz.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+const int runs = 5;
+
+template <class F>
+double best_seconds( F f )
+{
+	double best = 1e30;
+	for ( int r = 0; r < runs; ++r )
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		f();
+		chrono::duration<double> d = chrono::steady_clock::now() - start;
+		best = min( best, d.count() );
+	}
+	return best;
+}
+
+////////////////////////////////////////
+
+node *name( const string &s, char quote )
+{
+	return new literal( s.data(), s.data() + s.size(), quote );
+}
+
+////////////////////////////////////////
+
+// A random factor: a reference to another production or a literal,
+// sometimes wrapped in an optional, a repetition or a one-or-more.
+node *factor( mt19937 &rng, size_t count, int depth );
+
+node *alternatives( mt19937 &rng, size_t count, int depth )
+{
+	node *expr = NULL;
+	int nalts = int( rng() % 3 ) + 1;
+	for ( int a = 0; a < nalts; ++a )
+	{
+		node *t = factor( rng, count, depth );
+		int nfactors = int( rng() % 4 );
+		for ( int f = 0; f < nfactors; ++f )
+			t = new term( t, factor( rng, count, depth ) );
+		expr = expr ? new expression( expr, t ) : t;
+	}
+	return expr;
+}
+
+node *factor( mt19937 &rng, size_t count, int depth )
+{
+	int kind = int( rng() % 10 );
+	if ( depth < 2 && kind >= 7 )
+	{
+		node *inner = alternatives( rng, count, depth + 1 );
+		if ( kind == 7 )
+			return new optional( inner );
+		if ( kind == 8 )
+			return new repetition( inner );
+		return new onemore( inner );
+	}
+	if ( kind < 4 )
+		return name( "kw" + to_string( rng() % 100 ), '\'' );
+	return name( "rule_" + to_string( rng() % count ), '\0' );
+}
+
+////////////////////////////////////////
+
+node *make_grammar( size_t count )
+{
+	mt19937 rng( 1 );
+	node *prods = NULL;
+	for ( size_t i = 0; i < count; ++i )
+	{
+		node *p = new production( name( "rule_" + to_string( i ), '\0' ), alternatives( rng, count, 0 ) );
+		prods = prods ? new productions( prods, p ) : p;
+	}
+	return new grammar( name( "Benchmark", 'T' ), prods );
+}
+
+////////////////////////////////////////
+
+// Render gram through the virtual interface of draw, or through the
+// statically bound overload for the backend's own type.
+template <class DC>
+size_t render_with( const node *gram, buffer &out, bool virt )
+{
+	out.clear();
+	{
+		DC dc( out );
+		if ( virt )
+			render( static_cast<draw &>( dc ), gram );
+		else
+			render( dc, gram );
+	}
+	return out.size();
+}
+
+template <class DC>
+void compare( const char *label, const node *gram, buffer &out )
+{
+	size_t virt_bytes = 0, static_bytes = 0;
+	double virt = best_seconds( [&]() { virt_bytes = render_with<DC>( gram, out, true ); } );
+	double stat = best_seconds( [&]() { static_bytes = render_with<DC>( gram, out, false ); } );
+	cout << label << "  virtual " << virt << "s  static " << stat << "s";
+	if ( virt_bytes != static_bytes )
+		cout << "  (output differs: " << virt_bytes << " vs " << static_bytes << " bytes)";
+	cout << '\n';
+}
+
+// Render gram the way draw_grammar does for each output format, and
+// print how many MB of output that writes per second.
+template <class DC>
+void throughput( const char *label, const node *gram, buffer &out )
+{
+	size_t bytes = 0;
+	double secs = best_seconds( [&]() { bytes = render_with<DC>( gram, out, false ); } );
+	cout << label << "  " << bytes / secs / 1e6 << " MB/s (" << bytes << " bytes in " << secs << "s)\n";
+}
+
+}
+
+////////////////////////////////////////
+
+// Generates a grammar of random productions (the same ones every time)
+// and renders it into memory through render( draw & ), and through
+// render( draw_svg & ) and render( draw_tikz & ), which bind the calls
+// into the backend statically.  Then renders it through each backend
+// and prints its output rate.  Each is timed as the best of 5 runs.
+//
+// Usage: render_bench [productions]
+int main( int argc, char *argv[] )
+{
+	size_t count = argc > 1 ? size_t( atol( argv[1] ) ) : 2000;
+	if ( count == 0 )
+		count = 1;
+
+	node_arena arena;
+	const node *gram = make_grammar( count );
+	buffer out;
+
+	cout << count << " productions\n";
+	compare<draw_svg>( "svg ", gram, out );
+	compare<draw_tikz>( "tikz", gram, out );
+
+	throughput<draw_svg>( "svg ", gram, out );
+	throughput<draw_html>( "html", gram, out );
+	throughput<draw_tikz>( "tex ", gram, out );
+	throughput<draw_pdf>( "pdf ", gram, out );
+	throughput<draw_json>( "json", gram, out );
+	throughput<draw_png>( "png ", gram, out );
+	return 0;
+}
@@ -0,0 +1,368 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <stdexcept>
+#include <vector>
+
+#include "simplify.h"
+#include "node.h"
+
+namespace
+{
+
+////////////////////////////////////////
+
+// The tree is built from node *, but read through const node *.
+inline node *mut( const node *n )
+{
+	return const_cast<node *>( n );
+}
+
+////////////////////////////////////////
+
+size_t count( const node *n )
+{
+	if ( n == NULL )
+		return 0;
+	if ( const grammar *g = dynamic_cast<const grammar*>( n ) )
+		return 1 + count( g->title() ) + count( g->prods() );
+	if ( const productions *p = dynamic_cast<const productions*>( n ) )
+	{
+		size_t ret = 1;
+		for ( size_t i = 0; i < p->size(); ++i )
+			ret += count( p->at( i ) );
+		return ret;
+	}
+	if ( const production *p = dynamic_cast<const production*>( n ) )
+		return 1 + count( p->id() ) + count( p->expr() );
+	if ( const expression *e = dynamic_cast<const expression*>( n ) )
+	{
+		size_t ret = 1;
+		for ( size_t i = 0; i < e->size(); ++i )
+			ret += count( e->at( i ) );
+		return ret;
+	}
+	if ( const term *t = dynamic_cast<const term*>( n ) )
+	{
+		size_t ret = 1;
+		for ( size_t i = 0; i < t->size(); ++i )
+			ret += count( t->at( i ) );
+		return ret;
+	}
+	if ( const repetition *r = dynamic_cast<const repetition*>( n ) )
+		return 1 + count( r->expr() );
+	if ( const onemore *o = dynamic_cast<const onemore*>( n ) )
+		return 1 + count( o->expr() ) + count( o->sep() );
+	if ( const optional *o = dynamic_cast<const optional*>( n ) )
+		return 1 + count( o->expr() );
+	return 1;
+}
+
+////////////////////////////////////////
+
+// Whether two subtrees have the same structure and symbols.
+bool same( const node *a, const node *b )
+{
+	if ( a == b )
+		return true;
+	if ( a == NULL || b == NULL )
+		return false;
+
+	if ( const literal *x = dynamic_cast<const literal*>( a ) )
+	{
+		const literal *y = dynamic_cast<const literal*>( b );
+		return y && x->quote() == y->quote() && x->value() == y->value();
+	}
+	if ( const expression *x = dynamic_cast<const expression*>( a ) )
+	{
+		const expression *y = dynamic_cast<const expression*>( b );
+		if ( !y || x->size() != y->size() )
+			return false;
+		for ( size_t i = 0; i < x->size(); ++i )
+		{
+			if ( !same( x->at( i ), y->at( i ) ) )
+				return false;
+		}
+		return true;
+	}
+	if ( const term *x = dynamic_cast<const term*>( a ) )
+	{
+		const term *y = dynamic_cast<const term*>( b );
+		if ( !y || x->size() != y->size() )
+			return false;
+		for ( size_t i = 0; i < x->size(); ++i )
+		{
+			if ( !same( x->at( i ), y->at( i ) ) )
+				return false;
+		}
+		return true;
+	}
+	if ( const repetition *x = dynamic_cast<const repetition*>( a ) )
+	{
+		const repetition *y = dynamic_cast<const repetition*>( b );
+		return y && same( x->expr(), y->expr() );
+	}
+	if ( const onemore *x = dynamic_cast<const onemore*>( a ) )
+	{
+		const onemore *y = dynamic_cast<const onemore*>( b );
+		return y && same( x->expr(), y->expr() ) && same( x->sep(), y->sep() );
+	}
+	if ( const optional *x = dynamic_cast<const optional*>( a ) )
+	{
+		const optional *y = dynamic_cast<const optional*>( b );
+		return y && same( x->expr(), y->expr() );
+	}
+	return false;
+}
+
+////////////////////////////////////////
+
+// The factors of a sequence: those of a term, or the node itself.
+vector<node *> factors( node *n )
+{
+	vector<node *> ret;
+	if ( const term *t = dynamic_cast<const term*>( n ) )
+	{
+		for ( size_t i = 0; i < t->size(); ++i )
+			ret.push_back( mut( t->at( i ) ) );
+	}
+	else
+		ret.push_back( n );
+	return ret;
+}
+
+////////////////////////////////////////
+
+// A sequence, with nested sequences spliced in.
+node *make_term( const vector<node *> &f )
+{
+	vector<node *> flat;
+	for ( size_t i = 0; i < f.size(); ++i )
+	{
+		vector<node *> sub = factors( f[i] );
+		flat.insert( flat.end(), sub.begin(), sub.end() );
+	}
+	if ( flat.size() == 1 )
+		return flat[0];
+	return new term( flat );
+}
+
+////////////////////////////////////////
+
+// A choice, with nested choices spliced in.
+node *make_expression( const vector<node *> &alts )
+{
+	vector<node *> flat;
+	for ( size_t i = 0; i < alts.size(); ++i )
+	{
+		if ( const expression *e = dynamic_cast<const expression*>( alts[i] ) )
+		{
+			for ( size_t j = 0; j < e->size(); ++j )
+				flat.push_back( mut( e->at( j ) ) );
+		}
+		else
+			flat.push_back( alts[i] );
+	}
+	if ( flat.size() == 1 )
+		return flat[0];
+	return new expression( flat );
+}
+
+////////////////////////////////////////
+
+// [ x ], { x } and < x > inside one another: [ [ x ] ] is [ x ],
+// < < x > > is < x >, and any other nesting of two is { x }.
+node *make_optional( node *e )
+{
+	if ( dynamic_cast<const optional*>( e ) || dynamic_cast<const repetition*>( e ) )
+		return e;
+	const onemore *o = dynamic_cast<const onemore*>( e );
+	if ( o && !o->sep() )
+		return new repetition( mut( o->expr() ) );
+	return new optional( e );
+}
+
+node *make_repetition( node *e )
+{
+	if ( dynamic_cast<const repetition*>( e ) )
+		return e;
+	if ( const optional *o = dynamic_cast<const optional*>( e ) )
+		return new repetition( mut( o->expr() ) );
+	const onemore *o = dynamic_cast<const onemore*>( e );
+	if ( o && !o->sep() )
+		return new repetition( mut( o->expr() ) );
+	return new repetition( e );
+}
+
+node *make_onemore( node *e )
+{
+	if ( dynamic_cast<const repetition*>( e ) )
+		return e;
+	if ( const optional *o = dynamic_cast<const optional*>( e ) )
+		return new repetition( mut( o->expr() ) );
+	const onemore *o = dynamic_cast<const onemore*>( e );
+	if ( o && !o->sep() )
+		return e;
+	return new onemore( e );
+}
+
+////////////////////////////////////////
+
+// Neighbouring alternatives that start alike share their longest common
+// prefix, followed by the choice between what is left of them.
+node *factor( const vector<node *> &alts )
+{
+	vector<node *> out;
+	for ( size_t i = 0; i < alts.size(); )
+	{
+		vector<vector<node *>> seqs( 1, factors( alts[i] ) );
+		size_t j = i + 1;
+		for ( ; j < alts.size(); ++j )
+		{
+			vector<node *> f = factors( alts[j] );
+			if ( !same( seqs[0][0], f[0] ) )
+				break;
+			seqs.push_back( f );
+		}
+		if ( seqs.size() == 1 )
+		{
+			out.push_back( alts[i++] );
+			continue;
+		}
+		i = j;
+
+		size_t len = 1;
+		for ( bool more = true; more; )
+		{
+			for ( size_t k = 0; more && k < seqs.size(); ++k )
+				more = len < seqs[k].size() && same( seqs[0][len], seqs[k][len] );
+			if ( more )
+				++len;
+		}
+
+		// An alternative that is all prefix makes the rest optional.
+		bool empty = false;
+		vector<node *> rest;
+		for ( size_t k = 0; k < seqs.size(); ++k )
+		{
+			if ( seqs[k].size() == len )
+				empty = true;
+			else
+				rest.push_back( make_term( vector<node *>( seqs[k].begin() + len, seqs[k].end() ) ) );
+		}
+
+		vector<node *> seq( seqs[0].begin(), seqs[0].begin() + len );
+		if ( !rest.empty() )
+		{
+			node *tail = factor( rest );
+			seq.push_back( empty ? make_optional( tail ) : tail );
+		}
+		out.push_back( make_term( seq ) );
+	}
+	return make_expression( out );
+}
+
+////////////////////////////////////////
+
+node *simplify_node( const node *n )
+{
+	if ( n == NULL )
+		return NULL;
+
+	if ( const grammar *g = dynamic_cast<const grammar*>( n ) )
+	{
+		node *prods = simplify_node( g->prods() );
+		if ( prods == g->prods() )
+			return mut( n );
+		return new grammar( mut( g->title() ), prods );
+	}
+	else if ( const productions *p = dynamic_cast<const productions*>( n ) )
+	{
+		productions *ret = new productions();
+		bool changed = false;
+		for ( size_t i = 0; i < p->size(); ++i )
+		{
+			ret->push_back( simplify_node( p->at( i ) ) );
+			changed = changed || ret->at( i ) != p->at( i );
+		}
+		return changed ? ret : mut( n );
+	}
+	else if ( const production *p = dynamic_cast<const production*>( n ) )
+	{
+		node *expr = simplify_node( p->expr() );
+		if ( expr == p->expr() )
+			return mut( n );
+		return new production( mut( p->id() ), expr );
+	}
+	else if ( const expression *e = dynamic_cast<const expression*>( n ) )
+	{
+		vector<node *> alts;
+		for ( size_t i = 0; i < e->size(); ++i )
+			alts.push_back( simplify_node( e->at( i ) ) );
+		node *ret = factor( alts );
+		return same( ret, n ) ? mut( n ) : ret;
+	}
+	else if ( const term *t = dynamic_cast<const term*>( n ) )
+	{
+		vector<node *> f;
+		for ( size_t i = 0; i < t->size(); ++i )
+			f.push_back( simplify_node( t->at( i ) ) );
+		node *ret = make_term( f );
+		return same( ret, n ) ? mut( n ) : ret;
+	}
+	else if ( const repetition *r = dynamic_cast<const repetition*>( n ) )
+	{
+		node *ret = make_repetition( simplify_node( r->expr() ) );
+		return same( ret, n ) ? mut( n ) : ret;
+	}
+	else if ( const onemore *o = dynamic_cast<const onemore*>( n ) )
+	{
+		node *ret;
+		if ( o->sep() )
+			ret = new onemore( simplify_node( o->expr() ), simplify_node( o->sep() ) );
+		else
+			ret = make_onemore( simplify_node( o->expr() ) );
+		return same( ret, n ) ? mut( n ) : ret;
+	}
+	else if ( const optional *o = dynamic_cast<const optional*>( n ) )
+	{
+		node *ret = make_optional( simplify_node( o->expr() ) );
+		return same( ret, n ) ? mut( n ) : ret;
+	}
+	else if ( dynamic_cast<const literal*>( n ) )
+		return mut( n );
+
+	throw runtime_error( "unknown node type" );
+}
+
+}
+
+////////////////////////////////////////
+
+simplify_result simplify( const node *gram )
+{
+	simplify_result ret;
+	ret.before = count( gram );
+	ret.gram = simplify_node( gram );
+	ret.after = count( ret.gram );
+	return ret;
+}
@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <cstddef>
+
+class node;
+
+using namespace std;
+
+////////////////////////////////////////
+
+struct simplify_result
+{
+	simplify_result( void )
+		: gram( NULL ), before( 0 ), after( 0 )
+	{
+	}
+
+	node *gram;
+	size_t before;
+	size_t after;
+};
+
+////////////////////////////////////////
+
+// Rewrites a grammar into an equivalent one with fewer boxes and rails:
+//
+//   ( a | b ) | c    becomes  a | b | c    (and the same for sequences)
+//   [ { x } ]        becomes  { x }        (and the other nestings of
+//                                           [ ], { } and < > without a
+//                                           separator)
+//   a b c | a b d    becomes  a b ( c | d )
+//   a b | a b c      becomes  a b [ c ]
+//
+// Only neighbouring alternatives are factored, so alternatives keep
+// their order.  Unchanged subtrees are shared with the original, and
+// before and after count the nodes of both trees.
+simplify_result simplify( const node *gram );
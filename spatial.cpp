@@ -0,0 +1,273 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "spatial.h"
+#include "render.h"
+#include "node.h"
+
+namespace
+{
+
+const size_t fanout = 16;
+const string empty_name;
+
+////////////////////////////////////////
+
+const string *literal_value( const node *n )
+{
+	if ( const literal *l = dynamic_cast<const literal*>( n ) )
+		return &l->value();
+	return &empty_name;
+}
+
+}
+
+////////////////////////////////////////
+
+const char *kind_name( Kind k )
+{
+	switch ( k )
+	{
+		case KIND_GRAMMAR: return "grammar";
+		case KIND_PRODUCTIONS: return "productions";
+		case KIND_PRODUCTION: return "production";
+		case KIND_EXPRESSION: return "expression";
+		case KIND_TERM: return "term";
+		case KIND_REPETITION: return "repetition";
+		case KIND_ONEMORE: return "onemore";
+		case KIND_OPTIONAL: return "optional";
+		case KIND_TITLE: return "title";
+		case KIND_NAME: return "name";
+		case KIND_NONTERM: return "nonterminal";
+		case KIND_TERMINAL: return "terminal";
+	}
+	return "unknown";
+}
+
+////////////////////////////////////////
+
+spatial_index::spatial_index( const render_context &ctxt, const node *gram )
+{
+	add( ctxt, gram, point(), 0, &empty_name );
+	build();
+}
+
+////////////////////////////////////////
+
+void spatial_index::at( float x, float y, vector<const hit *> &out ) const
+{
+	rect r = { x, y, x, y };
+	out.clear();
+	search( r, out );
+	sort( out.begin(), out.end(), []( const hit *a, const hit *b )
+	{
+		return a->depth != b->depth ? a->depth > b->depth : a->order < b->order;
+	} );
+}
+
+////////////////////////////////////////
+
+void spatial_index::in( float x, float y, float w, float h, vector<const hit *> &out ) const
+{
+	rect r = { x, y, x + w, y + h };
+	out.clear();
+	search( r, out );
+	sort( out.begin(), out.end(), []( const hit *a, const hit *b )
+	{
+		return a->order < b->order;
+	} );
+}
+
+////////////////////////////////////////
+
+// Boxes are relative to the top left corner of their parent's, which
+// origin is in the drawing.
+void spatial_index::add( const render_context &ctxt, const node *n, const point &origin, int depth, const string *prod )
+{
+	if ( n == NULL )
+		return;
+	auto b = ctxt.data.find( n );
+	if ( b == ctxt.data.end() )
+		throw runtime_error( "grammar has not been laid out" );
+
+	hit h;
+	h.n = n;
+	h.symbol = &empty_name;
+	h.production = prod;
+	h.x = origin.x + b->second.x();
+	h.y = origin.y + b->second.y();
+	h.w = b->second.width();
+	h.h = b->second.height();
+	h.depth = depth;
+	h.order = _hits.size();
+
+	size_t self = _hits.size();
+	_hits.push_back( h );
+
+	point inner( h.x, h.y );
+	++depth;
+	if ( const grammar *g = dynamic_cast<const grammar*>( n ) )
+	{
+		_hits[self].kind = KIND_GRAMMAR;
+		size_t title = _hits.size();
+		add( ctxt, g->title(), inner, depth, prod );
+		if ( title < _hits.size() )
+			_hits[title].kind = KIND_TITLE;
+		add( ctxt, g->prods(), inner, depth, prod );
+	}
+	else if ( const productions *p = dynamic_cast<const productions*>( n ) )
+	{
+		_hits[self].kind = KIND_PRODUCTIONS;
+		for ( size_t i = 0; i < p->size(); ++i )
+			add( ctxt, p->at( i ), inner, depth, prod );
+	}
+	else if ( const production *p = dynamic_cast<const production*>( n ) )
+	{
+		const string *name = literal_value( p->id() );
+		_hits[self].kind = KIND_PRODUCTION;
+		_hits[self].symbol = name;
+		_hits[self].production = name;
+		size_t id = _hits.size();
+		add( ctxt, p->id(), inner, depth, name );
+		if ( id < _hits.size() )
+			_hits[id].kind = KIND_NAME;
+		add( ctxt, p->expr(), inner, depth, name );
+	}
+	else if ( const expression *e = dynamic_cast<const expression*>( n ) )
+	{
+		_hits[self].kind = KIND_EXPRESSION;
+		for ( size_t i = 0; i < e->size(); ++i )
+			add( ctxt, e->at( i ), inner, depth, prod );
+	}
+	else if ( const term *t = dynamic_cast<const term*>( n ) )
+	{
+		_hits[self].kind = KIND_TERM;
+		for ( size_t i = 0; i < t->size(); ++i )
+			add( ctxt, t->at( i ), inner, depth, prod );
+	}
+	else if ( const repetition *r = dynamic_cast<const repetition*>( n ) )
+	{
+		_hits[self].kind = KIND_REPETITION;
+		add( ctxt, r->expr(), inner, depth, prod );
+	}
+	else if ( const onemore *o = dynamic_cast<const onemore*>( n ) )
+	{
+		_hits[self].kind = KIND_ONEMORE;
+		add( ctxt, o->expr(), inner, depth, prod );
+		add( ctxt, o->sep(), inner, depth, prod );
+	}
+	else if ( const optional *o = dynamic_cast<const optional*>( n ) )
+	{
+		_hits[self].kind = KIND_OPTIONAL;
+		add( ctxt, o->expr(), inner, depth, prod );
+	}
+	else if ( const literal *l = dynamic_cast<const literal*>( n ) )
+	{
+		_hits[self].kind = l->quote() == '\0' ? KIND_NONTERM : KIND_TERMINAL;
+		_hits[self].symbol = &l->value();
+	}
+	else
+		throw runtime_error( "unknown node type" );
+}
+
+////////////////////////////////////////
+
+void spatial_index::build( void )
+{
+	if ( _hits.empty() )
+		return;
+
+	_boxes.reserve( _hits.size() );
+	for ( const hit &h: _hits )
+	{
+		rect r = { h.x, h.y, h.x + h.w, h.y + h.h };
+		_boxes.push_back( r );
+	}
+
+	const vector<rect> *below = &_boxes;
+	while ( below->size() > 1 )
+	{
+		vector<rect> level( ( below->size() + fanout - 1 ) / fanout );
+		for ( size_t i = 0; i < level.size(); ++i )
+		{
+			size_t first = i * fanout;
+			size_t last = std::min( first + fanout, below->size() );
+			rect r = ( *below )[first];
+			for ( size_t j = first + 1; j < last; ++j )
+			{
+				const rect &b = ( *below )[j];
+				r.x1 = std::min( r.x1, b.x1 );
+				r.y1 = std::min( r.y1, b.y1 );
+				r.x2 = std::max( r.x2, b.x2 );
+				r.y2 = std::max( r.y2, b.y2 );
+			}
+			level[i] = r;
+		}
+		_levels.push_back( level );
+		below = &_levels.back();
+	}
+}
+
+////////////////////////////////////////
+
+void spatial_index::search( const rect &r, vector<const hit *> &out ) const
+{
+	auto overlaps = [&]( const rect &b )
+	{
+		return b.x1 <= r.x2 && r.x1 <= b.x2 && b.y1 <= r.y2 && r.y1 <= b.y2;
+	};
+
+	if ( _levels.empty() )
+	{
+		if ( !_boxes.empty() && overlaps( _boxes[0] ) )
+			out.push_back( &_hits[0] );
+		return;
+	}
+	if ( !overlaps( _levels.back()[0] ) )
+		return;
+
+	// Nodes that overlap, as level (1 for the one above the hits) and
+	// index in it.
+	vector<pair<size_t,size_t>> stack;
+	stack.push_back( make_pair( _levels.size(), size_t( 0 ) ) );
+	while ( !stack.empty() )
+	{
+		size_t level = stack.back().first;
+		size_t i = stack.back().second;
+		stack.pop_back();
+
+		const vector<rect> &below = level == 1 ? _boxes : _levels[level - 2];
+		size_t last = std::min( ( i + 1 ) * fanout, below.size() );
+		for ( size_t j = i * fanout; j < last; ++j )
+		{
+			if ( !overlaps( below[j] ) )
+				continue;
+			if ( level == 1 )
+				out.push_back( &_hits[j] );
+			else
+				stack.push_back( make_pair( level - 1, j ) );
+		}
+	}
+}
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "draw.h"
+
+class node;
+struct render_context;
+
+using namespace std;
+
+////////////////////////////////////////
+
+// What a box in the layout stands for.
+enum Kind
+{
+	KIND_GRAMMAR,
+	KIND_PRODUCTIONS,
+	KIND_PRODUCTION,
+	KIND_EXPRESSION,
+	KIND_TERM,
+	KIND_REPETITION,
+	KIND_ONEMORE,
+	KIND_OPTIONAL,
+	KIND_TITLE,
+	KIND_NAME,
+	KIND_NONTERM,
+	KIND_TERMINAL
+};
+
+const char *kind_name( Kind k );
+
+////////////////////////////////////////
+
+// A node of the grammar and where it was laid out, in the coordinates
+// of the full drawing.  symbol is the text of titles, names, terminals
+// and nonterminals (the production's name for a production), and
+// production the name of the production the node is part of.  Both are
+// empty when there is none.
+struct hit
+{
+	const node *n;
+	Kind kind;
+	const string *symbol;
+	const string *production;
+	float x, y, w, h;
+	int depth;
+	size_t order;
+};
+
+////////////////////////////////////////
+
+// Answers which nodes lie at a point or in a rectangle of a laid out
+// grammar, without drawing it.  The boxes of all nodes are packed into
+// a static R-tree in grammar order, which keeps a node next to its
+// children and neighbours, so the boxes of each level are grouped
+// straight into those of the level above.
+class spatial_index
+{
+public:
+	// ctxt must hold the layout of gram (see layout() in render.h).
+	spatial_index( const render_context &ctxt, const node *gram );
+
+	size_t size( void ) const { return _hits.size(); }
+
+	// The nodes whose box contains (x, y), innermost first.
+	void at( float x, float y, vector<const hit *> &out ) const;
+
+	// The nodes whose box overlaps the rectangle, in grammar order.
+	void in( float x, float y, float w, float h, vector<const hit *> &out ) const;
+
+private:
+	struct rect
+	{
+		float x1, y1, x2, y2;
+	};
+
+	void add( const render_context &ctxt, const node *n, const point &origin, int depth, const string *prod );
+	void build( void );
+
+	void search( const rect &r, vector<const hit *> &out ) const;
+
+	vector<hit> _hits;
+	vector<rect> _boxes;
+	// Every level above the hits, from the bottom: node i of a level
+	// covers nodes [i*fanout, (i+1)*fanout) of the one below.
+	vector<vector<rect>> _levels;
+};
@@ -0,0 +1,269 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "split.h"
+#include "render.h"
+#include "escape.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+struct part_file
+{
+	string name;
+	string file;
+	part_box box;
+};
+
+////////////////////////////////////////
+
+// Production names become file names: anything but letters, digits,
+// '-' and '_' is replaced, and names that would clash (ignoring case,
+// for the file systems that do) get a number.
+string file_name( const string &name, const string &ext, set<string> &used )
+{
+	string base;
+	for ( size_t i = 0; i < name.size(); ++i )
+	{
+		char c = name[i];
+		base += ( isalnum( (unsigned char)c ) || c == '-' || c == '_' ) ? c : '_';
+	}
+	if ( base.empty() )
+		base = "part";
+
+	string file = base;
+	for ( int n = 2; ; ++n )
+	{
+		string key( file );
+		transform( key.begin(), key.end(), key.begin(), ::tolower );
+		if ( used.insert( key ).second )
+			break;
+		file = base + '-' + to_string( n );
+	}
+	return file + '.' + ext;
+}
+
+////////////////////////////////////////
+
+bool same_contents( const string &filename, const buffer &contents )
+{
+	int fd = open( filename.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		return false;
+
+	bool same = false;
+	struct stat st;
+	if ( fstat( fd, &st ) == 0 && size_t( st.st_size ) == contents.size() )
+	{
+		vector<char> old( 1 << 16 );
+		size_t pos = 0;
+		same = true;
+		while ( same && pos < contents.size() )
+		{
+			ssize_t n = read( fd, &old[0], std::min( old.size(), contents.size() - pos ) );
+			if ( n <= 0 )
+				same = false;
+			else
+			{
+				same = memcmp( &old[0], contents.data() + pos, size_t( n ) ) == 0;
+				pos += size_t( n );
+			}
+		}
+	}
+	close( fd );
+	return same;
+}
+
+////////////////////////////////////////
+
+// The SVG index puts every part back where it was in the full layout.
+void svg_index( buffer &out, const vector<part_file> &parts )
+{
+	float w = 0, h = 0;
+	for ( size_t i = 0; i < parts.size(); ++i )
+	{
+		w = std::max( w, parts[i].box.x + parts[i].box.w );
+		h = std::max( h, parts[i].box.y + parts[i].box.h );
+	}
+
+	out <<
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" "
+		"xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+		"width=\"" << number( w, 3 ) << "px\" height=\"" << number( h, 3 ) << "px\">\n";
+	for ( size_t i = 0; i < parts.size(); ++i )
+	{
+		const part_box &b = parts[i].box;
+		out << "  <image x=\"" << number( b.x, 3 ) << "\" y=\"" << number( b.y, 3 ) <<
+			"\" width=\"" << number( b.w, 3 ) << "\" height=\"" << number( b.h, 3 ) << "\" xlink:href=\"";
+		xml_escape( out, parts[i].file );
+		out << "\"/>\n";
+	}
+	out << "</svg>\n";
+}
+
+////////////////////////////////////////
+
+void html_index( buffer &out, const string &title, const vector<part_file> &parts )
+{
+	out <<
+		"<html>\n"
+		"<head>\n"
+		"  <title>";
+	xml_escape( out, title );
+	out << "</title>\n"
+		"  <meta http-equiv=\"Content-Type\" content=\"text/html; charset=UTF-8\"></meta>\n"
+		"</head>\n"
+		"<body>\n"
+		"<ul>\n";
+	for ( size_t i = 0; i < parts.size(); ++i )
+	{
+		out << "<li><a href=\"";
+		xml_escape( out, parts[i].file );
+		out << "\">";
+		xml_escape( out, parts[i].name );
+		out << "</a></li>\n";
+	}
+	out << "</ul>\n"
+		"</body>\n"
+		"</html>\n";
+}
+
+////////////////////////////////////////
+
+void tex_index( buffer &out, const vector<part_file> &parts )
+{
+	for ( size_t i = 0; i < parts.size(); ++i )
+		out << "\\input{" << parts[i].file << "}\n";
+}
+
+}
+
+////////////////////////////////////////
+
+bool write_if_changed( const string &filename, const buffer &contents )
+{
+	if ( same_contents( filename, contents ) )
+		return false;
+
+	string tmp = filename + ".tmp";
+	int fd = open( tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+	if ( fd < 0 )
+		throw runtime_error( "could not open " + tmp + ": " + strerror( errno ) );
+
+	const char *p = contents.data();
+	size_t left = contents.size();
+	while ( left > 0 )
+	{
+		ssize_t n = write( fd, p, left );
+		if ( n < 0 && errno == EINTR )
+			continue;
+		if ( n <= 0 )
+		{
+			string err = strerror( errno );
+			close( fd );
+			unlink( tmp.c_str() );
+			throw runtime_error( "could not write " + tmp + ": " + err );
+		}
+		p += n;
+		left -= size_t( n );
+	}
+
+	if ( close( fd ) != 0 || rename( tmp.c_str(), filename.c_str() ) != 0 )
+	{
+		string err = strerror( errno );
+		unlink( tmp.c_str() );
+		throw runtime_error( "could not write " + filename + ": " + err );
+	}
+	return true;
+}
+
+////////////////////////////////////////
+
+split_result write_split( const node *gram, const string &dir, const string &ext, const function<draw *( buffer &out )> &backend )
+{
+	if ( mkdir( dir.c_str(), 0777 ) != 0 && errno != EEXIST )
+		throw runtime_error( "could not create directory " + dir + ": " + strerror( errno ) );
+
+	split_result ret;
+	vector<part_file> parts;
+	set<string> used;
+	used.insert( "index" );
+
+	buffer out;
+	unique_ptr<draw> dc;
+	auto begin = [&]( const string &name, const part_box &box ) -> draw &
+	{
+		part_file p;
+		p.name = name;
+		p.file = file_name( name, ext, used );
+		p.box = box;
+		parts.push_back( p );
+
+		out.clear();
+		dc.reset( backend( out ) );
+		return *dc;
+	};
+	auto done = [&]( const string &name )
+	{
+		dc.reset();
+		if ( write_if_changed( dir + '/' + parts.back().file, out ) )
+			++ret.written;
+		else
+			++ret.unchanged;
+	};
+	render_parts( gram, begin, done );
+
+	out.clear();
+	if ( ext == "svg" )
+		svg_index( out, parts );
+	else if ( ext == "html" )
+		html_index( out, grammar_title( gram ), parts );
+	else
+		tex_index( out, parts );
+	if ( write_if_changed( dir + "/index." + ext, out ) )
+		++ret.written;
+	else
+		++ret.unchanged;
+
+	return ret;
+}
+
+////////////////////////////////////////
+
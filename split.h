@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "buffer.h"
+#include "draw.h"
+
+class node;
+
+using namespace std;
+
+////////////////////////////////////////
+
+struct split_result
+{
+	split_result( void )
+		: written( 0 ), unchanged( 0 )
+	{
+	}
+
+	size_t written;
+	size_t unchanged;
+};
+
+////////////////////////////////////////
+
+// Returns false when the file already held exactly these contents.
+// Otherwise they are written to a temporary file that then replaces
+// it, so readers never see a partial file.
+bool write_if_changed( const string &filename, const buffer &contents );
+
+////////////////////////////////////////
+
+// Writes the title and every production of a grammar into files of
+// their own in dir (name.ext), plus an index.ext that ties them
+// together.  ext is svg, html or tex, and backend() makes the draw
+// object for each file.  Files whose contents did not change are left
+// alone, so their timestamps stay put for make and rsync.
+split_result write_split( const node *gram, const string &dir, const string &ext, const function<draw *( buffer &out )> &backend );
+
+////////////////////////////////////////
+
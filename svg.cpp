@@ -20,17 +20,43 @@
 // OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
 
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 
 #include "svg.h"
+#include "escape.h"
 
 using namespace std;
 
 ////////////////////////////////////////
 
-draw_svg::draw_svg( ostream &o )
-	: draw( o )
+namespace
+{
+
+// Replaces the presentation attributes that used to be repeated on
+// every element.  It comes after the svg.css link, so it wins over any
+// rule of svg.css as specific as its own; those rules say the same as
+// svg.css, and output looks the same with or without it.
+const char *stylesheet =
+	"text{font-family:\"Courier New\",Courier,monospace;font-weight:bold;font-size:20px;"
+	"alignment-baseline:central;stroke:none;fill:black}\n"
+	"text.nonterm{fill:#A00000}\n"
+	"text.literal{fill:green}\n"
+	"text.keyword{fill:#3F00DD}\n"
+	"rect,circle,path{stroke:black;fill:none;stroke-width:2px}\n"
+	"path.arrow{stroke:none;fill:black}\n"
+	"rect.test{stroke-width:1px}\n";
+
+}
+
+////////////////////////////////////////
+
+draw_svg::draw_svg( buffer &o )
+	: draw( o ), minify( false ), styled( false ), arrows_defined( 0 ), last_cmd( 0 ), path_sep( false ), path_point( false ),
+	  cur_x( 0 ), cur_y( 0 ), sub_x( 0 ), sub_y( 0 )
 {
 }
 
@@ -56,14 +82,31 @@ void draw_svg::end( void )
 
 void draw_svg::id_begin( float x, float y, float w, float h, const string &name )
 {
-	out <<
-		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-		"<?xml-stylesheet href=\"svg.css\" type=\"text/css\"?>\n"
-		"<svg overflow=\"visible\" "
-		"xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" "
-		"xmlns:svg=\"http://www.w3.org/2000/svg\" "
-		"xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
-		"width=\"" << w << "px\" height=\"" << h << "px\">\n";
+	close_path();
+	if ( minify )
+	{
+		// UTF-8 is the default encoding, pixels the default unit, and
+		// nothing uses the svg: prefix.
+		out <<
+			"<?xml-stylesheet href=\"svg.css\" type=\"text/css\"?>\n"
+			"<svg overflow=\"visible\" "
+			"xmlns=\"http://www.w3.org/2000/svg\" "
+			"xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+			"width=\"" << num( w ) << "\" height=\"" << num( h ) << "\">\n";
+	}
+	else
+	{
+		out <<
+			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<?xml-stylesheet href=\"svg.css\" type=\"text/css\"?>\n"
+			"<svg overflow=\"visible\" "
+			"xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" "
+			"xmlns:svg=\"http://www.w3.org/2000/svg\" "
+			"xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+			"width=\"" << num( w ) << "px\" height=\"" << num( h ) << "px\">\n";
+	}
+	if ( !styled )
+		style();
 	push_translate( point( x, y ) );
 }
 
@@ -71,6 +114,8 @@ void draw_svg::id_begin( float x, float y, float w, float h, const string &name
 
 void draw_svg::id_end( void )
 {
+	close_path();
+	arrow_defs();
 	pop_translate();
 	out << "</svg>\n";
 }
@@ -79,131 +124,356 @@ void draw_svg::id_end( void )
 
 void draw_svg::link_begin( const string &name )
 {
-	out << "  <a xlink:href=\"#" << name << "\">\n";
+	close_path();
+	out << indent() << "<a xlink:href=\"#";
+	xml_escape( out, name );
+	out << "\">\n";
 }
 
 ////////////////////////////////////////
 
 void draw_svg::link_end( void )
 {
-	out << "  </a>\n";
+	close_path();
+	out << indent() << "</a>\n";
+}
+
+////////////////////////////////////////
+
+void draw_svg::part_begin( float x, float y, float w, float h, const string &name )
+{
+	close_path();
+	out << indent() << "<g id=\"";
+	xml_escape( out, name );
+	out << "\">\n";
+}
+
+////////////////////////////////////////
+
+void draw_svg::part_end( void )
+{
+	close_path();
+	out << indent() << "</g>\n";
 }
 
 ////////////////////////////////////////
 
 void draw_svg::box( float x, float y, float w, float h, Class cl )
 {
-	out << "  <rect x=\"" << xx(x+0.5F) << "\" y=\"" << yy(y+0.5F) << "\" width=\"" << w << "\" height=\"" << h << "\" class=" << clname( cl ) << "></rect>\n";
+	close_path();
+	out << indent() << "<rect x=\"" << num( xx(x+0.5F) ) << "\" y=\"" << num( yy(y+0.5F) ) << "\" width=\"" << num( w ) << "\" height=\"" << num( h ) << "\" class=\"" << clname( cl ) << ( minify ? "\"/>\n" : "\"></rect>\n" );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::circle( float x, float y, float r, Class cl )
 {
-	out << "  <circle cx=\"" << xx(x+0.5F) << "\" cy=\"" << yy(y+0.5F) << "\" r=\"" << r << "\" class=" << clname( cl ) << " />\n";
+	close_path();
+	out << indent() << "<circle cx=\"" << num( xx(x+0.5F) ) << "\" cy=\"" << num( yy(y+0.5F) ) << "\" r=\"" << num( r ) << "\" class=\"" << clname( cl ) << ( minify ? "\"/>\n" : "\" />\n" );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::round( float x, float y, float w, float h, Class cl )
 {
-	out << "  <rect rx=\"" << h/2.F << "\" ry=\"" << h/2.F << "\" x=\"" << xx(x + 0.5F) << "\" y=\"" << yy(y + 0.5F) << "\" width=\"" << w << "\" height=\"" << h << "\" class=" << clname( cl ) << "></rect>\n";
+	close_path();
+	out << indent() << "<rect rx=\"" << num( h/2.F );
+	// ry defaults to rx.
+	if ( !minify )
+		out << "\" ry=\"" << num( h/2.F );
+	out << "\" x=\"" << num( xx(x + 0.5F) ) << "\" y=\"" << num( yy(y + 0.5F) ) << "\" width=\"" << num( w ) << "\" height=\"" << num( h ) << "\" class=\"" << clname( cl ) << ( minify ? "\"/>\n" : "\"></rect>\n" );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::text( float x, float y, float w, float h, const string &text, Class cl )
 {
-	out << "  <text x=\"" << xx(x) << "\" y=\"" << yy(y + h/2.F) << "\" alignment-baseline=\"central\" class=" << clname( cl, true ) << ">";
-	out << escape( text ) << "</text>\n";
+	close_path();
+	out << indent() << "<text x=\"" << num( xx(x) ) << "\" y=\"" << num( yy(y + h/2.F) ) << ( minify ? "\" text-anchor=\"start" : "" ) << "\" class=\"" << clname( cl ) << "\">";
+	xml_escape( out, text );
+	out << "</text>\n";
 }
 
 ////////////////////////////////////////
 
 void draw_svg::text_center( float x, float y, float w, float h, const string &text, Class cl )
 {
-	out << "  <text x=\"" << xx(x + w/2.F) << "\" y=\"" << yy(y + h/2.F) << "\" text-anchor=\"middle\" alignment-baseline=\"central\" class=" << clname( cl, true ) << ">";
-	out << escape( text ) << "</text>\n";
+	close_path();
+	out << indent() << "<text x=\"" << num( xx(x + w/2.F) ) << "\" y=\"" << num( yy(y + h/2.F) ) << ( minify ? "" : "\" text-anchor=\"middle" ) << "\" class=\"" << clname( cl ) << "\">";
+	xml_escape( out, text );
+	out << "</text>\n";
+}
+
+////////////////////////////////////////
+
+void draw_svg::hline( const point &p1, const point &p2, Class cl )
+{
+	static_hline( *this, p1, p2, cl );
+}
+
+////////////////////////////////////////
+
+void draw_svg::vline( const point &p1, const point &p2, Class cl )
+{
+	static_vline( *this, p1, p2, cl );
+}
+
+////////////////////////////////////////
+
+void draw_svg::path( const point &p1, const point &p2, float r, Arc dir, Class cl )
+{
+	static_path( *this, p1, p2, r, dir, cl );
+}
+
+////////////////////////////////////////
+
+void draw_svg::path( Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl )
+{
+	static_path( *this, d1, p1, p2, d2, r, cl );
+}
+
+////////////////////////////////////////
+
+void draw_svg::arrow_left( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	static_arrow_left( *this, p, l, size, cl1, cl2 );
+}
+
+////////////////////////////////////////
+
+void draw_svg::arrow_right( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	static_arrow_right( *this, p, l, size, cl1, cl2 );
+}
+
+////////////////////////////////////////
+
+void draw_svg::arrow_down( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	static_arrow_down( *this, p, l, size, cl1, cl2 );
+}
+
+////////////////////////////////////////
+
+// Arrowheads are references to one definition per shape.  Inside an
+// open path they are held back until the path is finished, so the
+// rails on either side still end up in the same element.
+void draw_svg::arrow_head( float x, float y, Direction d, float size, Class cl )
+{
+	const string &id = arrow_id( d, size, cl );
+	buffer &o = open_path >= 0 ? heads : out;
+	o << indent() << "<use xlink:href=\"#" << id << "\" x=\"" << num( xx(x) ) << "\" y=\"" << num( yy(y) ) << "\"/>\n";
+}
+
+////////////////////////////////////////
+
+bool draw_svg::reuses_groups( void ) const
+{
+	return true;
+}
+
+////////////////////////////////////////
+
+// The first drawing of a repeated subtree is wrapped in a group, and
+// later ones become a <use> of it, offset from where it was drawn.
+// Ids made up here (groups, arrowheads, and title_part of render.h)
+// start with '_', which identifiers in grammar.g cannot, so they never
+// clash with the ids of productions.
+bool draw_svg::group_begin( const string &key, float x, float y )
+{
+	close_path();
+	unordered_map<string,group_def>::const_iterator i = groups.find( key );
+	if ( i != groups.end() )
+	{
+		const group_def &g = i->second;
+		out << indent() << "<use xlink:href=\"#" << g.id << "\" x=\"" << num( xx(x) - g.x ) << "\" y=\"" << num( yy(y) - g.y ) << "\"/>\n";
+		return true;
+	}
+
+	group_def &g = groups[key];
+	stringstream id;
+	id << "_g" << groups.size();
+	g.id = id.str();
+	g.x = xx(x);
+	g.y = yy(y);
+	out << indent() << "<g id=\"" << g.id << "\">\n";
+	return false;
+}
+
+////////////////////////////////////////
+
+void draw_svg::group_end( void )
+{
+	close_path();
+	out << indent() << "</g>\n";
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_begin( float x, float y, Class cl )
 {
-	out << "  <path class=" << clname( cl ) << " d=\"M " << xx(x) << ' ' << yy(y);
+	out << indent() << "<path class=\"" << clname( cl ) << "\" d=\"M";
+	last_cmd = 'M';
+	path_sep = false;
+	path_start( xx(x), yy(y) );
+}
+
+////////////////////////////////////////
+
+void draw_svg::path_move( float x, float y )
+{
+	if ( minify )
+	{
+		path_cmd( 'm' );
+		path_arg( snap( xx(x) ) - cur_x );
+		path_arg( snap( yy(y) ) - cur_y );
+		cur_x = sub_x = snap( xx(x) );
+		cur_y = sub_y = snap( yy(y) );
+	}
+	else
+	{
+		path_cmd( 'M' );
+		path_start( xx(x), yy(y) );
+	}
 }
 
 ////////////////////////////////////////
 
+// Minified paths leave out segments that round to nothing.
 void draw_svg::path_h_by( float x )
 {
-	out << " h " << x;
+	if ( minify && snap( x ) == 0 )
+		return;
+	path_cmd( 'h' );
+	path_arg( x );
+	cur_x += snap( x );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_v_by( float y )
 {
-	out << " v " << y;
+	if ( minify && snap( y ) == 0 )
+		return;
+	path_cmd( 'v' );
+	path_arg( y );
+	cur_y += snap( y );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_h_to( float x )
 {
-	out << " H " << xx(x);
+	if ( minify )
+		path_h_by( snap( xx(x) ) - cur_x );
+	else
+	{
+		path_cmd( 'H' );
+		path_arg( xx(x) );
+	}
+	cur_x = snap( xx(x) );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_v_to( float y )
 {
-	out << " V " << yy(y);
+	if ( minify )
+		path_v_by( snap( yy(y) ) - cur_y );
+	else
+	{
+		path_cmd( 'V' );
+		path_arg( yy(y) );
+	}
+	cur_y = snap( yy(y) );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_to( float x, float y )
 {
-	out << " L " << xx(x) << ' ' << yy(y);
+	if ( minify )
+	{
+		path_cmd( 'l' );
+		path_arg( snap( xx(x) ) - cur_x );
+		path_arg( snap( yy(y) ) - cur_y );
+	}
+	else
+	{
+		path_cmd( 'L' );
+		path_arg( xx(x) );
+		path_arg( yy(y) );
+	}
+	cur_x = snap( xx(x) );
+	cur_y = snap( yy(y) );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_arc( float r, Arc a )
 {
+	bool sweep = false;
+	float ex = r, ey = r;
 	switch ( a )
 	{
-		case RIGHT_UP: out << " a " << r << ' ' << r << " 0 0 0 " << r << ' ' << -r; break;
-		case RIGHT_DOWN: out << " a " << r << ' ' << r << " 0 0 1 " << r << ' ' << r; break;
-		case LEFT_UP: out << " a " << r << ' ' << r << " 0 0 1 " << -r << ' ' << -r; break;
-		case LEFT_DOWN: out << " a " << r << ' ' << r << " 0 0 0 " << -r << ' ' << r; break;
-		case UP_RIGHT: out << " a " << r << ' ' << r << " 0 0 1 " << r << ' ' << -r; break;
-		case UP_LEFT: out << " a " << r << ' ' << r << " 0 0 0 " << -r << ' ' << -r; break;
-		case DOWN_RIGHT: out << " a " << r << ' ' << r << " 0 0 0 " << r << ' ' << r; break;
-		case DOWN_LEFT: out << " a " << r << ' ' << r << " 0 0 1 " << -r << ' ' << r; break;
+		case RIGHT_UP: ey = -r; break;
+		case RIGHT_DOWN: sweep = true; break;
+		case LEFT_UP: sweep = true; ex = -r; ey = -r; break;
+		case LEFT_DOWN: ex = -r; break;
+		case UP_RIGHT: sweep = true; ey = -r; break;
+		case UP_LEFT: ex = -r; ey = -r; break;
+		case DOWN_RIGHT: break;
+		case DOWN_LEFT: sweep = true; ex = -r; break;
 	}
+
+	path_cmd( 'a' );
+	path_arg( r );
+	path_arg( r );
+	path_arg( 0 );
+	path_arg( 0 );
+	path_arg( sweep ? 1 : 0 );
+	path_arg( ex );
+	path_arg( ey );
+	cur_x += snap( ex );
+	cur_y += snap( ey );
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_arrow_left( float size )
 {
-	out << " l " << size << ' ' << size/2 << " 0 " << -size << " z";
+	path_cmd( 'l' );
+	path_arg( size );
+	path_arg( size/2 );
+	path_arg( 0 );
+	path_arg( -size );
+	path_close();
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_arrow_right( float size )
 {
-	out << " l " << -size << ' ' << -size/2 << " 0 " << size << ' ' << size << ' ' << -size/2 << " z";
+	path_cmd( 'l' );
+	path_arg( -size );
+	path_arg( -size/2 );
+	path_arg( 0 );
+	path_arg( size );
+	path_arg( size );
+	path_arg( -size/2 );
+	path_close();
 }
 
 ////////////////////////////////////////
 
 void draw_svg::path_arrow_down( float size )
 {
-	out << " l " << -size/2 << ' ' << -size << ' ' << size << " 0 " << " z";
+	path_cmd( 'l' );
+	path_arg( -size/2 );
+	path_arg( -size );
+	path_arg( size );
+	path_arg( 0 );
+	path_close();
 }
 
 ////////////////////////////////////////
@@ -211,76 +481,175 @@ void draw_svg::path_arrow_down( float size )
 void draw_svg::path_end( void )
 {
 	out << "\"/>\n";
+	if ( heads.size() > 0 )
+	{
+		out.append( heads.data(), heads.size() );
+		heads.clear();
+	}
 }
 
 ////////////////////////////////////////
 
-string draw_svg::escape( const string &t )
+// Coordinates of an absolute move, which also starts a new subpath.
+// These are output coordinates (already translated).
+void draw_svg::path_start( float x, float y )
 {
-	string ret;
-	for ( size_t i = 0; i < t.size(); ++i )
+	path_arg( x );
+	path_arg( y );
+	cur_x = sub_x = snap( x );
+	cur_y = sub_y = snap( y );
+}
+
+////////////////////////////////////////
+
+// Minified paths leave out a command letter that repeats the previous
+// one (except for moves, whose repeats mean line-to).
+void draw_svg::path_cmd( char c )
+{
+	if ( minify )
 	{
-		switch ( t[i] )
-		{
-			case '<':
-				ret.append( "&lt;" );
-				break;
-			case '>':
-				ret.append( "&gt;" );
-				break;
-			default:
-				ret.push_back( t[i] );
-				break;
-		}
+		if ( c == last_cmd && c != 'm' && c != 'M' )
+			return;
+		out << c;
+		path_sep = false;
 	}
+	else
+		out << ' ' << c;
+	last_cmd = c;
+}
+
+////////////////////////////////////////
 
-	return ret;
+// Minified paths only separate numbers that would otherwise run
+// together: a sign, or a second decimal point, starts a new number.
+void draw_svg::path_arg( float v )
+{
+	number n( num( v ) );
+	if ( minify )
+	{
+		char c = n.data()[0];
+		if ( path_sep && ( ( c >= '0' && c <= '9' ) || ( c == '.' && !path_point ) ) )
+			out << ' ';
+		path_sep = true;
+		path_point = memchr( n.data(), '.', n.size() ) != NULL;
+	}
+	else
+		out << ' ';
+	out << n;
+}
+
+////////////////////////////////////////
+
+void draw_svg::path_close( void )
+{
+	path_cmd( 'z' );
+	cur_x = sub_x;
+	cur_y = sub_y;
 }
 
 ////////////////////////////////////////
 
-string draw_svg::clname( Class cl, bool text )
+// Round v the same way num() prints it, so relative commands do not
+// drift from the absolute positions.
+float draw_svg::snap( float v ) const
 {
-	if ( text )
+	int p = precision < 0 ? 0 : ( precision > 9 ? 9 : precision );
+	double scale = pow( 10.0, p );
+	double r = floor( fabs( double( v ) ) * scale + 0.5 ) / scale;
+	return float( v < 0 ? -r : r );
+}
+
+////////////////////////////////////////
+
+const char *draw_svg::clname( Class cl )
+{
+	switch ( cl )
 	{
-		std::string ret;
-		switch ( cl )
-		{
-			case LINE: ret = "\"line\" fill=\"black\""; break;
-			case ARROW: ret = "\"arrow\" fill=\"black\""; break;
-			case BOX: ret = "\"box\" fill=\"black\""; break;
-			case TITLE: ret = "\"title\" fill=\"black\""; break;
-			case PRODUCTION: ret = "\"prod\" fill=\"black\""; break;
-			case NONTERM: ret = "\"nonterm\" fill=\"red\""; break;
-			case LITERAL: ret = "\"literal\" fill=\"green\""; break;
-			case IDENTIFIER: ret = "\"ident\" fill=\"black\""; break;
-			case KEYWORD: ret = "\"keyword\" fill=\"blue\""; break;
-			case END: ret = "\"end\" fill=\"black\""; break;
-			case TEST: ret = "\"test\" fill=\"black\""; break;
-		}
-		if ( ret.empty() )
-			return "\"unknown\"";
-		return ret + " stroke=\"none\" font-family=\"Courier,monospace\" font-weight=\"bold\" font-size=\"20px\"";
+		case LINE: return "line";
+		case ARROW: return "arrow";
+		case BOX: return "box";
+		case TITLE: return "title";
+		case PRODUCTION: return "prod";
+		case NONTERM: return "nonterm";
+		case LITERAL: return "literal";
+		case IDENTIFIER: return "ident";
+		case KEYWORD: return "keyword";
+		case END: return "end";
+		case TEST: return "test";
 	}
+
+	return "unknown";
+}
+
+////////////////////////////////////////
+
+void draw_svg::style( void )
+{
+	// Minified output centers text by default, since most of it is.
+	if ( minify )
+		out << "<style>\n" << stylesheet << "text{text-anchor:middle}\n</style>\n";
 	else
+		out << "<style type=\"text/css\">\n" << stylesheet << "</style>\n";
+	styled = true;
+}
+
+////////////////////////////////////////
+
+const string &draw_svg::arrow_id( Direction d, float size, Class cl )
+{
+	for ( size_t i = 0; i < arrows.size(); ++i )
+	{
+		const arrow_def &a = arrows[i];
+		if ( a.dir == d && a.size == size && a.cl == cl )
+			return a.id;
+	}
+
+	arrow_def a;
+	a.dir = d;
+	a.size = size;
+	a.cl = cl;
+	a.id = string( "_" ) + clname( cl );
+	switch ( d )
 	{
-		switch ( cl )
+		case LEFT: a.id += "-l"; break;
+		case RIGHT: a.id += "-r"; break;
+		case DOWN: a.id += "-d"; break;
+		default: throw runtime_error( "Not yet implemented" );
+	}
+	number n( size, precision );
+	a.id.append( n.data(), n.size() );
+	arrows.push_back( a );
+	return arrows.back().id;
+}
+
+////////////////////////////////////////
+
+void draw_svg::arrow_defs( void )
+{
+	// Only the arrows not defined yet: a document with several <svg>
+	// elements shares the definitions of the earlier ones.
+	if ( arrows_defined == arrows.size() )
+		return;
+
+	out << "<defs>\n";
+	for ( size_t i = arrows_defined; i < arrows.size(); ++i )
+	{
+		const arrow_def &a = arrows[i];
+		out << indent() << "<path id=\"" << a.id << "\" class=\"" << clname( a.cl ) << "\" d=\"M";
+		last_cmd = 'M';
+		path_sep = false;
+		path_start( 0, 0 );
+		switch ( a.dir )
 		{
-			case LINE: return "\"line\" stoke-width=\"2px\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case ARROW: return "\"arrow\" stroke=\"none\" fill=\"black\" stroke-width=\"2px\"";
-			case BOX: return "\"box\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case TITLE: return "\"title\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case PRODUCTION: return "\"prod\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case NONTERM: return "\"nonterm\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case LITERAL: return "\"literal\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case IDENTIFIER: return "\"ident\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case KEYWORD: return "\"keyword\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case END: return "\"end\" stroke=\"black\" fill=\"none\" stroke-width=\"2px\"";
-			case TEST: return "\"test\" stroke=\"black\" fill=\"none\"";
+			case LEFT: path_arrow_left( a.size ); break;
+			case RIGHT: path_arrow_right( a.size ); break;
+			case DOWN: path_arrow_down( a.size ); break;
+			default: break;
 		}
+		out << "\"/>\n";
 	}
-
-	return "\"unknown\"";
+	out << "</defs>\n";
+	arrows_defined = arrows.size();
 }
 
 ////////////////////////////////////////
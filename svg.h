@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "draw.h"
@@ -33,40 +34,109 @@ using namespace std;
 class draw_svg : public draw
 {
 public:
-	draw_svg( ostream &o );
+	draw_svg( buffer &o );
 	virtual ~draw_svg( void );
 
+	// Smaller output: relative path commands, no redundant attributes
+	// or separators, and no indentation.
+	void set_minify( bool m ) { minify = m; }
+
 	virtual void begin( const string &title );
 	virtual void end( void );
 
 	virtual void id_begin( float x, float y, float w, float h, const string &name );
 	virtual void id_end();
 
-	virtual void link_begin( const string &name );
-	virtual void link_end();
+	virtual void link_begin( const string &name ) final;
+	virtual void link_end() final;
+
+	// Every part is a group with its name as id, for links to point at.
+	virtual void part_begin( float x, float y, float w, float h, const string &name );
+	virtual void part_end( void );
+
+	virtual void circle( float x, float y, float r, Class cl ) final;
+	virtual void box( float x, float y, float w, float h, Class cl ) final;
+	virtual void round( float x, float y, float w, float h, Class c ) final;
+	virtual void text( float x, float y, float w, float h, const string &text, Class cl ) final;
+	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl ) final;
+
+	virtual void hline( const point &p1, const point &p2, Class cl ) final;
+	virtual void vline( const point &p1, const point &p2, Class cl ) final;
+
+	virtual void path( const point &p1, const point &p2, float r, Arc dir, Class cl ) final;
+	virtual void path( Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl ) final;
+
+	virtual void arrow_left( const point &p, float l, float size, Class cl1, Class cl2 ) final;
+	virtual void arrow_right( const point &p, float l, float size, Class cl1, Class cl2 ) final;
+	virtual void arrow_down( const point &p, float l, float size, Class cl1, Class cl2 ) final;
+
+	virtual void arrow_head( float x, float y, Direction d, float size, Class cl ) final;
 
-	virtual void circle( float x, float y, float r, Class cl );
-	virtual void box( float x, float y, float w, float h, Class cl );
-	virtual void round( float x, float y, float w, float h, Class c );
-	virtual void text( float x, float y, float w, float h, const string &text, Class cl );
-	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl );
+	virtual bool reuses_groups( void ) const final;
+	virtual bool group_begin( const string &key, float x, float y ) final;
+	virtual void group_end( void ) final;
 
-	virtual void path_begin( float x, float y, Class cl );
+	virtual void path_begin( float x, float y, Class cl ) final;
+	virtual void path_move( float x, float y ) final;
 
-	virtual void path_h_by( float x );
-	virtual void path_v_by( float y );
-	virtual void path_h_to( float x );
-	virtual void path_v_to( float y );
-	virtual void path_to( float x, float y );
-	virtual void path_arc( float r, Arc a );
-	virtual void path_arrow_left( float size );
-	virtual void path_arrow_right( float size );
-	virtual void path_arrow_down( float size );
+	virtual void path_h_by( float x ) final;
+	virtual void path_v_by( float y ) final;
+	virtual void path_h_to( float x ) final;
+	virtual void path_v_to( float y ) final;
+	virtual void path_to( float x, float y ) final;
+	virtual void path_arc( float r, Arc a ) final;
+	virtual void path_arrow_left( float size ) final;
+	virtual void path_arrow_right( float size ) final;
+	virtual void path_arrow_down( float size ) final;
 
-	virtual void path_end( void );
+	virtual void path_end( void ) final;
 
 protected:
-	string escape( const string &t );
-	string clname( Class cl, bool text = false );
+	// Hides draw::num() so minified output drops leading zeros too.
+	inline number num( float v ) const { return number( v, precision, minify ); }
+	inline const char *indent( void ) const { return minify ? "" : "  "; }
+
+	void path_start( float x, float y );
+	void path_cmd( char c );
+	void path_arg( float v );
+	void path_close( void );
+	float snap( float v ) const;
+
+	const char *clname( Class cl );
+	void style( void );
+	const string &arrow_id( Direction d, float size, Class cl );
+	void arrow_defs( void );
+
+	struct arrow_def
+	{
+		Direction dir;
+		float size;
+		Class cl;
+		string id;
+	};
+
+	// The first drawing of each repeated subtree, by key: its id and
+	// where it was drawn.
+	struct group_def
+	{
+		string id;
+		float x, y;
+	};
+
+	bool minify;
+	bool styled;
+	vector<arrow_def> arrows;
+	size_t arrows_defined;
+	unordered_map<string,group_def> groups;
+	buffer heads;
+
+	// Path state: the last command letter, whether the next number
+	// needs a separator (and whether the last one had a point), and the
+	// current point and subpath start in output coordinates.
+	char last_cmd;
+	bool path_sep;
+	bool path_point;
+	float cur_x, cur_y;
+	float sub_x, sub_y;
 };
 
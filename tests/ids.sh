@@ -0,0 +1,20 @@
+#!/bin/sh
+#
+# Productions named like the ids made up for groups and the title part
+# must not give two elements the same id.
+#
+# Usage: ids.sh <draw_grammar>
+
+set -e
+dg=$1
+dir=$(dirname "$0")
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+"$dg" "$dir/ids.ebnf" "$out/ids.svg" "$out/ids.html"
+for f in "$out/ids.svg" "$out/ids.html"
+do
+	grep -q 'id="top"' "$f"
+	grep -q 'id="g1"' "$f"
+	test -z "$( grep -o 'id="[^"]*"' "$f" | sort | uniq -d )"
+done
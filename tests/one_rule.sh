@@ -0,0 +1,25 @@
+#!/bin/sh
+#
+# A grammar with a single production has no list of productions, but
+# that production must still be drawn as a part of its own.
+#
+# Usage: one_rule.sh <draw_grammar>
+
+set -e
+dg=$1
+dir=$(dirname "$0")
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+# Every shape is inside the <svg> of a part.
+"$dg" "$dir/one_rule.ebnf" "$out/one_rule.html"
+grep -q '<div class="part" id="only"' "$out/one_rule.html"
+awk '/<svg/ { d++ } /<\/svg>/ { d-- } /<(path|text|rect|circle|use)/ && d == 0 { bad = 1 } END { exit bad }' "$out/one_rule.html"
+
+# The production gets a file of its own.
+"$dg" --split "$out/split" "$dir/one_rule.ebnf" html svg
+for f in only.html only.svg index.html index.svg
+do
+	test -s "$out/split/$f"
+done
+grep -q 'only' "$out/split/index.svg"
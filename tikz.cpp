@@ -25,14 +25,17 @@
 #include <stdexcept>
 
 #include "tikz.h"
+#include "escape.h"
 
 using namespace std;
 
 ////////////////////////////////////////
 
-draw_tikz::draw_tikz( ostream &o )
+draw_tikz::draw_tikz( buffer &o )
 	: draw( o ), last_x( 0 ), last_y( 0 )
 {
+	// Hundredths of an em are well below what a printer can show.
+	set_precision( 2 );
 }
 
 ////////////////////////////////////////
@@ -45,19 +48,28 @@ draw_tikz::~draw_tikz( void )
 
 void draw_tikz::begin( const string &title )
 {
-	std::string t = escape( title );
-	out <<
-		"\\begin{figure}[htbp]\n"
-		"\\caption{" << t << "}\n"
-		"\\label{fig:" << t << "}\n"
+	out << "\\begin{figure}[htbp]\n\\caption{";
+	tex_escape( out, title );
+	out << "}\n\\label{fig:";
+	tex_escape( out, title );
+	// Coordinates are plain numbers in em, and the most common shapes
+	// are macros, which makes the picture about a third shorter.
+	out << "}\n"
 		"\\center\n"
-		"\\begin{tikzpicture}[yscale=-1]\n";
+		"\\begin{tikzpicture}[x=1em,y=1em,yscale=-1]\n"
+		"\\def\\dgbox#1#2#3#4#5{\\draw[#1](#2,#3)rectangle(#4,#5);}\n"
+		"\\def\\dground#1#2#3#4#5#6{\\draw[#1,rounded corners=#6em](#2,#3)rectangle(#4,#5);}\n"
+		"\\def\\dgtext#1#2#3#4{\\draw[#1](#2,#3)node[anchor=mid]{#4};}\n"
+		"\\def\\dgal#1#2#3#4{\\fill[arrow](#1,#2)--++(#3,#4)--++(0,-#3)--cycle;}\n"
+		"\\def\\dgar#1#2#3#4{\\fill[arrow](#1,#2)--++(-#3,-#4)--++(0,#3)--cycle;}\n"
+		"\\def\\dgad#1#2#3#4{\\fill[arrow](#1,#2)--++(-#4,-#3)--++(#3,0)--cycle;}\n";
 }
 
 ////////////////////////////////////////
 
 void draw_tikz::end( void )
 {
+	close_path();
 	out <<
 		"\\end{tikzpicture}\n"
 		"\\end{figure}\n";
@@ -93,37 +105,118 @@ void draw_tikz::link_end( void )
 
 void draw_tikz::box( float x, float y, float w, float h, Class cl )
 {
-	out << "  " << clname(cl) << " (" << em(xx(x)) << "em," << em(yy(y)) << "em) rectangle (" << em(xx(x+w)) << "em," << em(yy(y+h)) << "em);\n";
+	close_path();
+	out << "\\dgbox{" << style( cl ) << "}{" << num( xx(x) ) << "}{" << num( yy(y) ) << "}{" << num( xx(x+w) ) << "}{" << num( yy(y+h) ) << "}\n";
 }
 
 ////////////////////////////////////////
 
 void draw_tikz::circle( float x, float y, float r, Class cl )
 {
-	out << "  " << clname( cl ) << " (" << em(xx(x)) << "em," << em(yy(y)) << "em) circle (" << em(r) << "em);\n";
+	close_path();
+	out << clname( cl ) << "(" << num( xx(x) ) << ',' << num( yy(y) ) << ")circle(" << num( r ) << "em);\n";
 }
 
 ////////////////////////////////////////
 
 void draw_tikz::round( float x, float y, float w, float h, Class cl )
 {
-	out << "  " << clname( cl ) << "[rounded corners=" << em(h/2.F) << "em] (" << em(xx(x)) << "em," << em(yy(y)) << "em) rectangle (" << em(xx(x+w)) << "em," << em(yy(y+h)) << "em);\n";
+	close_path();
+	out << "\\dground{" << style( cl ) << "}{" << num( xx(x) ) << "}{" << num( yy(y) ) << "}{" << num( xx(x+w) ) << "}{" << num( yy(y+h) ) << "}{" << num( h/2.F ) << "}\n";
 }
 
 ////////////////////////////////////////
 
 void draw_tikz::text( float x, float y, float w, float h, const string &text, Class cl )
 {
+	close_path();
 	// The title is the figure name, so skip drawing it again.
 	if ( cl != TITLE )
-		out << "  " << clname( cl ) << " (" << em(xx(x+w/2.F)) << "em," << em(yy(y+h/2.F)) << "em) node[anchor=mid] {" << escape( text ) << "};\n";
+		text_center( x, y, w, h, text, cl );
 }
 
 ////////////////////////////////////////
 
 void draw_tikz::text_center( float x, float y, float w, float h, const string &text, Class cl )
 {
-	out << "  " << clname( cl ) << " (" << em(xx(x+w/2.F)) << "em," << em(yy(y+h/2.F)) << "em) node[anchor=mid] {" << escape( text ) << "};\n";
+	close_path();
+	out << "\\dgtext{" << style( cl ) << "}{" << num( xx(x+w/2.F) ) << "}{" << num( yy(y+h/2.F) ) << "}{";
+	tex_escape( out, text );
+	out << "}\n";
+}
+
+////////////////////////////////////////
+
+void draw_tikz::hline( const point &p1, const point &p2, Class cl )
+{
+	static_hline( *this, p1, p2, cl );
+}
+
+////////////////////////////////////////
+
+void draw_tikz::vline( const point &p1, const point &p2, Class cl )
+{
+	static_vline( *this, p1, p2, cl );
+}
+
+////////////////////////////////////////
+
+void draw_tikz::path( const point &p1, const point &p2, float r, Arc dir, Class cl )
+{
+	static_path( *this, p1, p2, r, dir, cl );
+}
+
+////////////////////////////////////////
+
+void draw_tikz::path( Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl )
+{
+	static_path( *this, d1, p1, p2, d2, r, cl );
+}
+
+////////////////////////////////////////
+
+void draw_tikz::arrow_left( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	static_arrow_left( *this, p, l, size, cl1, cl2 );
+}
+
+////////////////////////////////////////
+
+void draw_tikz::arrow_right( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	static_arrow_right( *this, p, l, size, cl1, cl2 );
+}
+
+////////////////////////////////////////
+
+void draw_tikz::arrow_down( const point &p, float l, float size, Class cl1, Class cl2 )
+{
+	static_arrow_down( *this, p, l, size, cl1, cl2 );
+}
+
+////////////////////////////////////////
+
+// Arrowheads use the macros defined in begin().  Inside an open path
+// they are held back until the path is finished.
+void draw_tikz::arrow_head( float x, float y, Direction d, float size, Class cl )
+{
+	if ( cl != ARROW )
+	{
+		static_arrow_head( *this, x, y, d, size, cl );
+		return;
+	}
+
+	const char *macro = NULL;
+	switch ( d )
+	{
+		case LEFT: macro = "\\dgal{"; break;
+		case RIGHT: macro = "\\dgar{"; break;
+		case DOWN: macro = "\\dgad{"; break;
+		default: throw runtime_error( "Not yet implemented" );
+	}
+
+	buffer &o = open_path >= 0 ? heads : out;
+	o << macro << num( xx(x) ) << "}{" << num( yy(y) ) << "}{" << num( size ) << "}{" << num( size/2 ) << "}\n";
 }
 
 ////////////////////////////////////////
@@ -131,7 +224,15 @@ void draw_tikz::text_center( float x, float y, float w, float h, const string &t
 void draw_tikz::path_begin( float x, float y, Class cl )
 {
 	last_x = x; last_y = y;
-	out << "  " << clname( cl ) << "(" << em(xx(x)) << "em," << em(yy(y)) << "em)";
+	out << clname( cl ) << "(" << num( xx(x) ) << ',' << num( yy(y) ) << ")";
+}
+
+////////////////////////////////////////
+
+void draw_tikz::path_move( float x, float y )
+{
+	last_x = x; last_y = y;
+	out << "(" << num( xx(x) ) << ',' << num( yy(y) ) << ")";
 }
 
 ////////////////////////////////////////
@@ -139,7 +240,7 @@ void draw_tikz::path_begin( float x, float y, Class cl )
 void draw_tikz::path_h_by( float x )
 {
 	last_x += x;
-	out << " -- ++(" << em(x) << "em,0em)";
+	out << "--++(" << num( x ) << ",0)";
 }
 
 ////////////////////////////////////////
@@ -147,7 +248,7 @@ void draw_tikz::path_h_by( float x )
 void draw_tikz::path_v_by( float y )
 {
 	last_y += y;
-	out << " -- ++(0em," << em(y) << "em)";
+	out << "--++(0," << num( y ) << ")";
 }
 
 ////////////////////////////////////////
@@ -155,7 +256,7 @@ void draw_tikz::path_v_by( float y )
 void draw_tikz::path_h_to( float x )
 {
 	last_x = x;
-	out << " -- (" << em(xx(x)) << "em," << em(yy(last_y)) << "em)";
+	out << "--(" << num( xx(x) ) << ',' << num( yy(last_y) ) << ")";
 }
 
 ////////////////////////////////////////
@@ -163,7 +264,7 @@ void draw_tikz::path_h_to( float x )
 void draw_tikz::path_v_to( float y )
 {
 	last_y = y;
-	out << " -- (" << em(xx(last_x)) << "em," << em(yy(y)) << "em)";
+	out << "--(" << num( xx(last_x) ) << ',' << num( yy(y) ) << ")";
 }
 
 ////////////////////////////////////////
@@ -171,7 +272,7 @@ void draw_tikz::path_v_to( float y )
 void draw_tikz::path_to( float x, float y )
 {
 	last_x = x; last_y = y;
-	out << " -- (" << em(xx(x)) << "em," << em(yy(y)) << "em)";
+	out << "--(" << num( xx(x) ) << ',' << num( yy(y) ) << ")";
 }
 
 ////////////////////////////////////////
@@ -180,14 +281,14 @@ void draw_tikz::path_arc( float r, Arc a )
 {
 	switch ( a )
 	{
-		case RIGHT_UP: out << " arc (90:0:" << em(r) << "em)"; last_x += r, last_y -= r;break;
-		case RIGHT_DOWN: out << " arc (-90:0:" << em(r) << "em)"; last_x += r, last_y += r;break;
-		case LEFT_UP: out << " arc (90:180:" << em(r) << "em)"; last_x -= r, last_y -= r;break;
-		case LEFT_DOWN: out << " arc (270:180:" << em(r) << "em)"; last_x -= r, last_y += r;break;
-		case UP_RIGHT: out << " arc (180:270:" << em(r) << "em)"; last_x += r, last_y -= r;break;
-		case UP_LEFT: out << " arc (0:-90:" << em(r) << "em)"; last_x -= r, last_y -= r;break;
-		case DOWN_RIGHT: out << " arc (180:90:" << em(r) << "em)"; last_x -= r, last_y += r;break;
-		case DOWN_LEFT: out << " arc (0:90:" << em(r) << "em)"; last_x += r, last_y += r;break;
+		case RIGHT_UP: out << "arc(90:0:" << num( r ) << "em)"; last_x += r, last_y -= r;break;
+		case RIGHT_DOWN: out << "arc(-90:0:" << num( r ) << "em)"; last_x += r, last_y += r;break;
+		case LEFT_UP: out << "arc(90:180:" << num( r ) << "em)"; last_x -= r, last_y -= r;break;
+		case LEFT_DOWN: out << "arc(270:180:" << num( r ) << "em)"; last_x -= r, last_y += r;break;
+		case UP_RIGHT: out << "arc(180:270:" << num( r ) << "em)"; last_x += r, last_y -= r;break;
+		case UP_LEFT: out << "arc(0:-90:" << num( r ) << "em)"; last_x -= r, last_y -= r;break;
+		case DOWN_RIGHT: out << "arc(180:90:" << num( r ) << "em)"; last_x -= r, last_y += r;break;
+		case DOWN_LEFT: out << "arc(0:90:" << num( r ) << "em)"; last_x += r, last_y += r;break;
 	}
 }
 
@@ -195,21 +296,21 @@ void draw_tikz::path_arc( float r, Arc a )
 
 void draw_tikz::path_arrow_left( float size )
 {
-	out << " -- ++(" << em( size ) << "em," << em( size/2 ) << "em) -- ++(0em," << em(-size) << "em) -- cycle";
+	out << "--++(" << num( size ) << ',' << num( size/2 ) << ")--++(0," << num( -size ) << ")--cycle";
 }
 
 ////////////////////////////////////////
 
 void draw_tikz::path_arrow_right( float size )
 {
-	out << " -- ++(" << em( -size ) << "em," << em( -size/2 ) << "em) -- ++(0em," << em(size) << "em) -- ++(" << em(size) << "em," << em(-size/2) << "em) -- cycle";
+	out << "--++(" << num( -size ) << ',' << num( -size/2 ) << ")--++(0," << num( size ) << ")--++(" << num( size ) << ',' << num( -size/2 ) << ")--cycle";
 }
 
 ////////////////////////////////////////
 
 void draw_tikz::path_arrow_down( float size )
 {
-	out << " -- ++(" << em(-size/2) << "em," << em(-size) << "em) -- ++(" << em(size) << "em,0em) -- cycle";
+	out << "--++(" << num( -size/2 ) << ',' << num( -size ) << ")--++(" << num( size ) << ",0)--cycle";
 }
 
 ////////////////////////////////////////
@@ -217,82 +318,40 @@ void draw_tikz::path_arrow_down( float size )
 void draw_tikz::path_end( void )
 {
 	out << ";\n";
-}
-
-////////////////////////////////////////
-
-string draw_tikz::escape( const string &t )
-{
-	string ret;
-	for ( size_t i = 0; i < t.size(); ++i )
+	if ( heads.size() > 0 )
 	{
-		switch ( t[i] )
-		{
-			case '{':
-				ret.append( "\\{" );
-				break;
-			case '}':
-				ret.append( "\\}" );
-				break;
-			case '_':
-				ret.append( "\\_" );
-				break;
-			case '&':
-				ret.append( "\\&" );
-				break;
-			case '%':
-				ret.append( "\\%" );
-				break;
-			case '#':
-				ret.append( "\\#" );
-				break;
-			case '$':
-				ret.append( "\\$" );
-				break;
-			case '~':
-				ret.append( "\\textasciitilde" );
-				break;
-			case '^':
-				ret.append( "\textasciicircum" );
-				break;
-			case '\\':
-				ret.append( "\\textbackslash" );
-				break;
-			default:
-				ret.push_back( t[i] );
-				break;
-		}
+		out.append( heads.data(), heads.size() );
+		heads.clear();
 	}
-
-	return ret;
 }
 
 ////////////////////////////////////////
 
-string draw_tikz::clname( Class cl )
+const char *draw_tikz::style( Class cl )
 {
 	switch ( cl )
 	{
-		case LINE: return "\\draw[line]"; break;
-		case ARROW: return "\\fill[arrow]";
-		case BOX: return "\\draw[box]"; break;
-		case TITLE: return "\\draw[title]"; break;
-		case PRODUCTION: return "\\draw[production]"; break;
-		case NONTERM: return "\\draw[nonterm]"; break;
-		case LITERAL: return "\\draw[literal]"; break;
-		case IDENTIFIER: return "\\draw[identifier]"; break;
-		case KEYWORD: return "\\draw[keyword]"; break;
-		case END: return "\\fill[end]";
-		case TEST: return "\\draw[test]"; break;
-		default: return "\\draw"; break;
+		case LINE: return "line";
+		case ARROW: return "arrow";
+		case BOX: return "box";
+		case TITLE: return "title";
+		case PRODUCTION: return "production";
+		case NONTERM: return "nonterm";
+		case LITERAL: return "literal";
+		case IDENTIFIER: return "identifier";
+		case KEYWORD: return "keyword";
+		case END: return "end";
+		case TEST: return "test";
+		default: return "";
 	}
-}	
+}
 
 ////////////////////////////////////////
 
-float draw_tikz::em( float x )
+string draw_tikz::clname( Class cl )
 {
-	return x / 24.F;
+	const char *cmd = ( cl == ARROW || cl == END ) ? "\\fill[" : "\\draw[";
+	return string( cmd ) + style( cl ) + ']';
 }
 
 ////////////////////////////////////////
@@ -33,7 +33,7 @@ using namespace std;
 class draw_tikz : public draw
 {
 public:
-	draw_tikz( ostream &o );
+	draw_tikz( buffer &o );
 	virtual ~draw_tikz( void );
 
 	virtual void begin( const string &title );
@@ -42,36 +42,54 @@ public:
 	virtual void id_begin( float x, float y, float w, float h, const string &name );
 	virtual void id_end();
 
-	virtual void link_begin( const string &name );
-	virtual void link_end();
+	virtual void link_begin( const string &name ) final;
+	virtual void link_end() final;
 
-	virtual void circle( float x, float y, float r, Class cl );
-	virtual void box( float x, float y, float w, float h, Class cl );
-	virtual void round( float x, float y, float w, float h, Class c );
-	virtual void text( float x, float y, float w, float h, const string &text, Class cl );
-	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl );
+	virtual void circle( float x, float y, float r, Class cl ) final;
+	virtual void box( float x, float y, float w, float h, Class cl ) final;
+	virtual void round( float x, float y, float w, float h, Class c ) final;
+	virtual void text( float x, float y, float w, float h, const string &text, Class cl ) final;
+	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl ) final;
 
-	virtual void path_begin( float x, float y, Class cl );
+	virtual void hline( const point &p1, const point &p2, Class cl ) final;
+	virtual void vline( const point &p1, const point &p2, Class cl ) final;
 
-	virtual void path_h_by( float x );
-	virtual void path_v_by( float y );
-	virtual void path_h_to( float x );
-	virtual void path_v_to( float y );
-	virtual void path_to( float x, float y );
-	virtual void path_arc( float r, Arc a );
-	virtual void path_arrow_left( float size );
-	virtual void path_arrow_right( float size );
-	virtual void path_arrow_down( float size );
+	virtual void path( const point &p1, const point &p2, float r, Arc dir, Class cl ) final;
+	virtual void path( Direction d1, const point &p1, const point &p2, Direction d2, float r, Class cl ) final;
 
-	virtual void path_end( void );
+	virtual void arrow_left( const point &p, float l, float size, Class cl1, Class cl2 ) final;
+	virtual void arrow_right( const point &p, float l, float size, Class cl1, Class cl2 ) final;
+	virtual void arrow_down( const point &p, float l, float size, Class cl1, Class cl2 ) final;
+
+	virtual void arrow_head( float x, float y, Direction d, float size, Class cl ) final;
+
+	virtual void path_begin( float x, float y, Class cl ) final;
+	virtual void path_move( float x, float y ) final;
+
+	virtual void path_h_by( float x ) final;
+	virtual void path_v_by( float y ) final;
+	virtual void path_h_to( float x ) final;
+	virtual void path_v_to( float y ) final;
+	virtual void path_to( float x, float y ) final;
+	virtual void path_arc( float r, Arc a ) final;
+	virtual void path_arrow_left( float size ) final;
+	virtual void path_arrow_right( float size ) final;
+	virtual void path_arrow_down( float size ) final;
+
+	virtual void path_end( void ) final;
 
 protected:
-	string escape( const string &t );
+	// Hides draw::num(): coordinates are written in em, the unit of
+	// the picture, without the zero before the point.
+	inline number num( float v ) const { return number( v / 24.F, precision, true ); }
+
+	const char *style( Class cl );
 	string clname( Class cl );
-	float em( float x );
 
 	float last_x;
 	float last_y;
+
+	buffer heads;
 };
 
 
@@ -0,0 +1,438 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "tiles.h"
+#include "render.h"
+#include "escape.h"
+
+using namespace std;
+
+////////////////////////////////////////
+
+namespace
+{
+
+// How far strokes reach past the shape they outline, and the width of
+// a character of 20px Courier.
+const float margin = 2.F;
+const float char_width = 12.F;
+
+}
+
+////////////////////////////////////////
+
+draw_tiles::draw_tiles( buffer &o, const string &e, int s, const function<draw *( buffer &out )> &b, const function<void( const string &file, const buffer &out )> &d )
+	: draw( o ), ext( e ), tile_size( s ), backend( b ), done( d ), padding( 0 ), cols( 0 ), rows( 0 ), finished( 0 ),
+	  path_class( LINE ), in_subpath( false ), min_x( 0 ), min_y( 0 ), max_x( 0 ), max_y( 0 )
+{
+	if ( tile_size <= 0 )
+		throw runtime_error( "tile size should be positive" );
+}
+
+////////////////////////////////////////
+
+draw_tiles::~draw_tiles( void )
+{
+}
+
+////////////////////////////////////////
+
+void draw_tiles::begin( const string &t )
+{
+	title = t;
+	written.clear();
+}
+
+////////////////////////////////////////
+
+void draw_tiles::end( void )
+{
+	close_path();
+	finish_rows( rows );
+
+	out << "{\"title\":\"";
+	json_escape( out, title );
+	out << "\",\"tile\":" << to_string( tile_size ) << ",\"width\":" << to_string( cols * tile_size ) << ",\"height\":" << to_string( rows * tile_size )
+		<< ",\"columns\":" << to_string( cols ) << ",\"rows\":" << to_string( rows ) << ",\"tiles\":[";
+	for ( size_t i = 0; i < written.size(); ++i )
+	{
+		int row = written[i] / cols, col = written[i] % cols;
+		out << ( i > 0 ? ",\n[" : "\n[" ) << to_string( row ) << ',' << to_string( col ) << ",\"" << to_string( row ) << '_' << to_string( col ) << '.' << ext << "\"]";
+	}
+	out << "]}\n";
+}
+
+////////////////////////////////////////
+
+// The grid covers the outer strokes, like the PNG output.
+void draw_tiles::id_begin( float x, float y, float w, float h, const string &name )
+{
+	cols = std::max( 1, int( ceil( ( w + 0.5F ) / float( tile_size ) ) ) );
+	rows = std::max( 1, int( ceil( ( h + 0.5F ) / float( tile_size ) ) ) );
+	finished = 0;
+	tiles.clear();
+	tiles.resize( size_t( cols ) * size_t( rows ) );
+	push_translate( point( x, y ) );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::id_end( void )
+{
+	close_path();
+	pop_translate();
+	finish_rows( rows );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::link_begin( const string &name )
+{
+}
+
+////////////////////////////////////////
+
+void draw_tiles::link_end( void )
+{
+}
+
+////////////////////////////////////////
+
+// Nothing of the parts before this one reaches above its top.
+void draw_tiles::part_begin( float x, float y, float w, float h, const string &name )
+{
+	close_path();
+	finish_rows( int( floor( ( yy(y) - margin ) / float( tile_size ) ) ) );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::circle( float x, float y, float r, Class cl )
+{
+	close_path();
+	float cx = xx(x), cy = yy(y);
+	each( cx - r, cy - r, cx + r, cy + r, [&]( draw &dc ) { dc.circle( cx, cy, r, cl ); } );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::box( float x, float y, float w, float h, Class cl )
+{
+	close_path();
+	float bx = xx(x), by = yy(y);
+	each( bx, by, bx + w, by + h, [&]( draw &dc ) { dc.box( bx, by, w, h, cl ); } );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::round( float x, float y, float w, float h, Class cl )
+{
+	close_path();
+	float bx = xx(x), by = yy(y);
+	each( bx, by, bx + w, by + h, [&]( draw &dc ) { dc.round( bx, by, w, h, cl ); } );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::text( float x, float y, float w, float h, const string &text, Class cl )
+{
+	close_path();
+	float bx = xx(x), by = yy(y);
+	float tw = std::max( w, float( text.size() ) * char_width );
+	each( bx, by, bx + tw, by + h, [&]( draw &dc ) { dc.text( bx, by, w, h, text, cl ); } );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::text_center( float x, float y, float w, float h, const string &text, Class cl )
+{
+	close_path();
+	float bx = xx(x), by = yy(y);
+	float tw = std::max( w, float( text.size() ) * char_width );
+	float cx = bx + w/2.F;
+	each( cx - tw/2.F, by, cx + tw/2.F, by + h, [&]( draw &dc ) { dc.text_center( bx, by, w, h, text, cl ); } );
+}
+
+////////////////////////////////////////
+
+// Arrowheads are drawn while their line may still be collected, so it
+// is passed on first.
+void draw_tiles::arrow_head( float x, float y, Direction d, float size, Class cl )
+{
+	subpath_end();
+	float ax = xx(x), ay = yy(y);
+	each( ax - size, ay - size, ax + size, ay + size, [&]( draw &dc ) { dc.arrow_head( ax, ay, d, size, cl ); } );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_begin( float x, float y, Class cl )
+{
+	path_class = cl;
+	path_move( x, y );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_move( float x, float y )
+{
+	subpath_end();
+	in_subpath = true;
+	cur = start = point( xx(x), yy(y) );
+	min_x = max_x = cur.x;
+	min_y = max_y = cur.y;
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_h_by( float x )
+{
+	add( segment::H_BY, x );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_v_by( float y )
+{
+	add( segment::V_BY, y );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_h_to( float x )
+{
+	add( segment::H_TO, xx(x) );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_v_to( float y )
+{
+	add( segment::V_TO, yy(y) );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_to( float x, float y )
+{
+	add( segment::TO, xx(x), yy(y) );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_arc( float r, Arc a )
+{
+	add( segment::ARC, r, float( a ) );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_arrow_left( float size )
+{
+	add( segment::ARROW_LEFT, size );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_arrow_right( float size )
+{
+	add( segment::ARROW_RIGHT, size );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_arrow_down( float size )
+{
+	add( segment::ARROW_DOWN, size );
+}
+
+////////////////////////////////////////
+
+void draw_tiles::path_end( void )
+{
+	subpath_end();
+	in_subpath = false;
+}
+
+////////////////////////////////////////
+
+template <typename F>
+void draw_tiles::each( float x0, float y0, float x1, float y1, F f )
+{
+	float s = float( tile_size );
+	int c0 = std::max( 0, int( floor( ( x0 - margin ) / s ) ) );
+	int c1 = std::min( cols - 1, int( floor( ( x1 + margin ) / s ) ) );
+	int r0 = std::max( 0, int( floor( ( y0 - margin ) / s ) ) );
+	int r1 = std::min( rows - 1, int( floor( ( y1 + margin ) / s ) ) );
+	for ( int r = r0; r <= r1; ++r )
+	{
+		for ( int c = c0; c <= c1; ++c )
+			f( at( r, c ) );
+	}
+}
+
+////////////////////////////////////////
+
+// Tiles are started when something is first drawn on them, with their
+// corner moved to the origin.
+draw &draw_tiles::at( int row, int col )
+{
+	if ( row < finished )
+		throw runtime_error( "drawing on a tile that was already written" );
+
+	unique_ptr<tile> &t = tiles[size_t( row ) * size_t( cols ) + size_t( col )];
+	if ( !t )
+	{
+		t.reset( new tile );
+		t->dc.reset( backend( t->out ) );
+		t->dc->begin( title );
+		t->dc->id_begin( -float( col * tile_size ), -float( row * tile_size ), float( tile_size ) - padding, float( tile_size ) - padding, title_part );
+	}
+	return *t->dc;
+}
+
+////////////////////////////////////////
+
+void draw_tiles::finish_rows( int row )
+{
+	row = std::min( row, rows );
+	for ( ; finished < row; ++finished )
+	{
+		for ( int c = 0; c < cols; ++c )
+		{
+			size_t i = size_t( finished ) * size_t( cols ) + size_t( c );
+			unique_ptr<tile> &t = tiles[i];
+			if ( !t )
+				continue;
+			t->dc->id_end();
+			t->dc->end();
+			t->dc.reset();
+			done( to_string( finished ) + '_' + to_string( c ) + '.' + ext, t->out );
+			t.reset();
+			written.push_back( int( i ) );
+		}
+	}
+}
+
+////////////////////////////////////////
+
+void draw_tiles::add( segment::Kind k, float a, float b )
+{
+	segment s = { k, a, b };
+	segments.push_back( s );
+
+	float e = 0.F;
+	switch ( k )
+	{
+		case segment::H_BY: cur.x += a; break;
+		case segment::V_BY: cur.y += a; break;
+		case segment::H_TO: cur.x = a; break;
+		case segment::V_TO: cur.y = a; break;
+		case segment::TO: cur = point( a, b ); break;
+		case segment::ARC:
+			// A quarter circle stays inside the box of its ends.
+			switch ( Arc( int( b ) ) )
+			{
+				case RIGHT_UP: case UP_RIGHT: cur = cur.move( a, -a ); break;
+				case RIGHT_DOWN: case DOWN_RIGHT: cur = cur.move( a, a ); break;
+				case LEFT_UP: case UP_LEFT: cur = cur.move( -a, -a ); break;
+				case LEFT_DOWN: case DOWN_LEFT: cur = cur.move( -a, a ); break;
+			}
+			break;
+		default: e = a; break;
+	}
+	min_x = std::min( min_x, cur.x - e );
+	min_y = std::min( min_y, cur.y - e );
+	max_x = std::max( max_x, cur.x + e );
+	max_y = std::max( max_y, cur.y + e );
+}
+
+////////////////////////////////////////
+
+// Pass the subpath collected so far on to the tiles it touches, where
+// it joins any open path of the same class.  Anything that follows
+// carries on from the current point.
+void draw_tiles::subpath_end( void )
+{
+	if ( !in_subpath || segments.empty() )
+		return;
+
+	each( min_x, min_y, max_x, max_y, [&]( draw &dc )
+	{
+		static_subpath_begin( dc, start.x, start.y, path_class );
+		for ( size_t i = 0; i < segments.size(); ++i )
+		{
+			const segment &s = segments[i];
+			switch ( s.kind )
+			{
+				case segment::H_BY: dc.path_h_by( s.a ); break;
+				case segment::V_BY: dc.path_v_by( s.a ); break;
+				case segment::H_TO: dc.path_h_to( s.a ); break;
+				case segment::V_TO: dc.path_v_to( s.a ); break;
+				case segment::TO: dc.path_to( s.a, s.b ); break;
+				case segment::ARC: dc.path_arc( s.a, Arc( int( s.b ) ) ); break;
+				case segment::ARROW_LEFT: dc.path_arrow_left( s.a ); break;
+				case segment::ARROW_RIGHT: dc.path_arrow_right( s.a ); break;
+				case segment::ARROW_DOWN: dc.path_arrow_down( s.a ); break;
+			}
+		}
+	} );
+
+	segments.clear();
+	start = cur;
+	min_x = max_x = cur.x;
+	min_y = max_y = cur.y;
+}
+
+////////////////////////////////////////
+
+split_result write_tiles( const node *gram, const string &dir, const string &ext, int size, const function<draw *( buffer &out )> &backend )
+{
+	if ( mkdir( dir.c_str(), 0777 ) != 0 && errno != EEXIST )
+		throw runtime_error( "could not create directory " + dir + ": " + strerror( errno ) );
+
+	split_result ret;
+	auto done = [&]( const string &file, const buffer &out )
+	{
+		if ( write_if_changed( dir + '/' + file, out ) )
+			++ret.written;
+		else
+			++ret.unchanged;
+	};
+
+	buffer manifest;
+	draw_tiles dc( manifest, ext, size, backend, done );
+	if ( ext == "png" )
+		dc.set_padding( 0.5F );
+	render( dc, gram );
+	done( "tiles." + ext + ".json", manifest );
+	return ret;
+}
+
+////////////////////////////////////////
@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "draw.h"
+#include "split.h"
+
+class node;
+
+using namespace std;
+
+////////////////////////////////////////
+
+// Cuts the drawing into square tiles, each drawn by a backend of its
+// own.  Every shape and subpath is passed on only to the tiles its
+// bounds touch, found from the grid of tiles directly.  Productions are
+// drawn top to bottom, so the rows of tiles above a production are
+// finished and handed to done() as soon as it begins.  Tiles are named
+// row_col.ext, and end() writes a JSON manifest of the tiles that are
+// not empty to the output:
+//
+//   {"title":"...","tile":size,"width":W,"height":H,"columns":C,"rows":R,
+//    "tiles":[[row,col,"row_col.ext"],...]}
+class draw_tiles : public draw
+{
+public:
+	draw_tiles( buffer &manifest, const string &ext, int size, const function<draw *( buffer &out )> &backend, const function<void( const string &file, const buffer &out )> &done );
+	virtual ~draw_tiles( void );
+
+	// draw_png makes room for the strokes on the outer edges itself.
+	void set_padding( float p ) { padding = p; }
+
+	virtual void begin( const string &title );
+	virtual void end( void );
+
+	virtual void id_begin( float x, float y, float w, float h, const string &name );
+	virtual void id_end();
+
+	virtual void link_begin( const string &name );
+	virtual void link_end();
+
+	virtual void part_begin( float x, float y, float w, float h, const string &name );
+
+	virtual void circle( float x, float y, float r, Class cl );
+	virtual void box( float x, float y, float w, float h, Class cl );
+	virtual void round( float x, float y, float w, float h, Class c );
+	virtual void text( float x, float y, float w, float h, const string &text, Class cl );
+	virtual void text_center( float x, float y, float w, float h, const string &text, Class cl );
+
+	virtual void arrow_head( float x, float y, Direction d, float size, Class cl );
+
+	virtual void path_begin( float x, float y, Class cl );
+	virtual void path_move( float x, float y );
+
+	virtual void path_h_by( float x );
+	virtual void path_v_by( float y );
+	virtual void path_h_to( float x );
+	virtual void path_v_to( float y );
+	virtual void path_to( float x, float y );
+	virtual void path_arc( float r, Arc a );
+	virtual void path_arrow_left( float size );
+	virtual void path_arrow_right( float size );
+	virtual void path_arrow_down( float size );
+
+	virtual void path_end( void );
+
+private:
+	struct tile
+	{
+		unique_ptr<draw> dc;
+		buffer out;
+	};
+
+	// A segment of the subpath being collected, in output coordinates.
+	struct segment
+	{
+		enum Kind { H_BY, V_BY, H_TO, V_TO, TO, ARC, ARROW_LEFT, ARROW_RIGHT, ARROW_DOWN } kind;
+		float a, b;
+	};
+
+	// Call f( dc ) for the backend of every tile that the box from
+	// (x0, y0) to (x1, y1) touches, in output coordinates.
+	template <typename F> void each( float x0, float y0, float x1, float y1, F f );
+
+	draw &at( int row, int col );
+	void finish_rows( int row );
+	void add( segment::Kind k, float a, float b = 0.F );
+	void subpath_end( void );
+
+	string ext;
+	int tile_size;
+	function<draw *( buffer &out )> backend;
+	function<void( const string &file, const buffer &out )> done;
+	float padding;
+
+	string title;
+	int cols, rows;
+	int finished;
+	vector<unique_ptr<tile>> tiles;
+	vector<int> written;
+
+	Class path_class;
+	bool in_subpath;
+	point start, cur;
+	float min_x, min_y, max_x, max_y;
+	vector<segment> segments;
+};
+
+////////////////////////////////////////
+
+// Tiled output: the grammar is drawn into size by size pixel tiles,
+// written as dir/row_col.ext (svg or png) for the tiles that are not
+// empty, plus a dir/tiles.ext.json manifest that lists them.  backend()
+// makes the draw object for each tile.
+split_result write_tiles( const node *gram, const string &dir, const string &ext, int size, const function<draw *( buffer &out )> &backend );
+
+////////////////////////////////////////
@@ -0,0 +1,210 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <stdexcept>
+
+#include "xref.h"
+#include "node.h"
+#include "escape.h"
+
+////////////////////////////////////////
+
+int symbol_table::intern( const string &name )
+{
+	auto i = _ids.insert( make_pair( name, int( _names.size() ) ) );
+	if ( i.second )
+		_names.push_back( &i.first->first );
+	return i.first->second;
+}
+
+////////////////////////////////////////
+
+int symbol_table::find( const string &name ) const
+{
+	auto i = _ids.find( name );
+	return i == _ids.end() ? -1 : i->second;
+}
+
+////////////////////////////////////////
+
+vector<const production *> grammar_productions( const node *gram )
+{
+	const grammar *g = dynamic_cast<const grammar*>( gram );
+	if ( !g )
+		throw runtime_error( "invalid grammar node" );
+
+	// A grammar with a single production has no list of them.
+	vector<const production *> ret;
+	if ( const productions *p = dynamic_cast<const productions*>( g->prods() ) )
+	{
+		for ( size_t i = 0; i < p->size(); ++i )
+		{
+			if ( const production *prod = dynamic_cast<const production*>( p->at( i ) ) )
+				ret.push_back( prod );
+		}
+	}
+	else if ( const production *prod = dynamic_cast<const production*>( g->prods() ) )
+		ret.push_back( prod );
+	return ret;
+}
+
+////////////////////////////////////////
+
+void each_nonterminal( const node *n, const function<void( const string &name )> &f )
+{
+	if ( const expression *e = dynamic_cast<const expression*>( n ) )
+	{
+		for ( size_t i = 0; i < e->size(); ++i )
+			each_nonterminal( e->at( i ), f );
+	}
+	else if ( const term *t = dynamic_cast<const term*>( n ) )
+	{
+		for ( size_t i = 0; i < t->size(); ++i )
+			each_nonterminal( t->at( i ), f );
+	}
+	else if ( const repetition *r = dynamic_cast<const repetition*>( n ) )
+		each_nonterminal( r->expr(), f );
+	else if ( const onemore *o = dynamic_cast<const onemore*>( n ) )
+	{
+		each_nonterminal( o->expr(), f );
+		if ( o->sep() )
+			each_nonterminal( o->sep(), f );
+	}
+	else if ( const optional *o = dynamic_cast<const optional*>( n ) )
+		each_nonterminal( o->expr(), f );
+	else if ( const literal *l = dynamic_cast<const literal*>( n ) )
+	{
+		if ( l->quote() == '\0' )
+			f( l->value() );
+	}
+}
+
+////////////////////////////////////////
+
+xref::xref( const node *gram )
+	: _prods( grammar_productions( gram ) )
+{
+	_defines.resize( _prods.size() );
+	_uses.resize( _prods.size() );
+	for ( size_t i = 0; i < _prods.size(); ++i )
+	{
+		const literal *id = dynamic_cast<const literal*>( _prods[i]->id() );
+		int sym = _symbols.intern( id ? id->value() : string() );
+		_defines[i] = sym;
+		if ( size_t( sym ) >= _defined_at.size() )
+		{
+			_defined_at.resize( _symbols.size() );
+			_used_at.resize( _symbols.size() );
+		}
+		_defined_at[size_t( sym )].push_back( int( i ) );
+	}
+
+	for ( size_t i = 0; i < _prods.size(); ++i )
+	{
+		each_nonterminal( _prods[i]->expr(), [&]( const string &name )
+		{
+			int sym = _symbols.intern( name );
+			if ( size_t( sym ) >= _used_at.size() )
+			{
+				_defined_at.resize( _symbols.size() );
+				_used_at.resize( _symbols.size() );
+			}
+
+			// A production is listed once however often it uses a
+			// symbol; its uses are all added before the next one's.
+			vector<int> &at = _used_at[size_t( sym )];
+			if ( at.empty() || at.back() != int( i ) )
+			{
+				at.push_back( int( i ) );
+				_uses[i].push_back( sym );
+			}
+		} );
+	}
+}
+
+////////////////////////////////////////
+
+bool xref::is_defined( const string &name ) const
+{
+	int sym = _symbols.find( name );
+	return sym >= 0 && !_defined_at[size_t( sym )].empty();
+}
+
+////////////////////////////////////////
+
+vector<int> xref::undefined( void ) const
+{
+	vector<int> ret;
+	for ( size_t i = 0; i < _symbols.size(); ++i )
+	{
+		if ( _defined_at[i].empty() )
+			ret.push_back( int( i ) );
+	}
+	return ret;
+}
+
+////////////////////////////////////////
+
+void xref::write_json( buffer &out ) const
+{
+	auto list = [&]( const vector<int> &prods )
+	{
+		out << '[';
+		for ( size_t i = 0; i < prods.size(); ++i )
+		{
+			if ( i > 0 )
+				out << ',';
+			out << to_string( prods[i] );
+		}
+		out << ']';
+	};
+
+	out << "{\"productions\":[";
+	for ( size_t i = 0; i < _prods.size(); ++i )
+	{
+		out << ( i > 0 ? ",\"" : "\"" );
+		json_escape( out, _symbols.name( _defines[i] ) );
+		out << '"';
+	}
+
+	out << "],\n\"symbols\":{";
+	for ( size_t i = 0; i < _symbols.size(); ++i )
+	{
+		out << ( i > 0 ? ",\n\"" : "\n\"" );
+		json_escape( out, _symbols.name( int( i ) ) );
+		out << "\":{\"defined\":";
+		list( _defined_at[i] );
+		out << ",\"used\":";
+		list( _used_at[i] );
+		out << '}';
+	}
+
+	out << "},\n\"undefined\":[";
+	vector<int> undef = undefined();
+	for ( size_t i = 0; i < undef.size(); ++i )
+	{
+		out << ( i > 0 ? ",\"" : "\"" );
+		json_escape( out, _symbols.name( undef[i] ) );
+		out << '"';
+	}
+	out << "]}\n";
+}
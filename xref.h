@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2012 Ian Godin
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+// OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer.h"
+
+class node;
+class production;
+
+using namespace std;
+
+////////////////////////////////////////
+
+// Gives every distinct name a small dense id, in the order the names
+// were first seen, so that sets and tables of them can be arrays.
+class symbol_table
+{
+public:
+	int intern( const string &name );
+
+	// The id of name, or -1 if it was never interned.
+	int find( const string &name ) const;
+
+	inline const string &name( int id ) const { return *_names[size_t( id )]; }
+	inline size_t size( void ) const { return _names.size(); }
+
+private:
+	unordered_map<string,int> _ids;
+	vector<const string *> _names;
+};
+
+////////////////////////////////////////
+
+// The productions of a grammar, in order.
+vector<const production *> grammar_productions( const node *gram );
+
+// Calls f with the name of every nonterminal in an expression, in order.
+void each_nonterminal( const node *expr, const function<void( const string &name )> &f );
+
+////////////////////////////////////////
+
+// Where every nonterminal of a grammar is defined and used, built in one
+// pass over the tree.  Productions are numbered in grammar order, and
+// symbols are the names of productions and nonterminals.
+class xref
+{
+public:
+	xref( const node *gram );
+
+	inline const symbol_table &symbols( void ) const { return _symbols; }
+
+	inline size_t prod_count( void ) const { return _prods.size(); }
+	inline const production *prod( size_t i ) const { return _prods[i]; }
+
+	// The symbol a production defines.
+	inline int defines( size_t prod ) const { return _defines[prod]; }
+
+	// The symbols a production refers to, each once, in order.
+	inline const vector<int> &uses( size_t prod ) const { return _uses[prod]; }
+
+	// The productions defining a symbol (more than one if it is defined
+	// twice), and those using it, each once.
+	inline const vector<int> &defined_at( int sym ) const { return _defined_at[size_t( sym )]; }
+	inline const vector<int> &used_at( int sym ) const { return _used_at[size_t( sym )]; }
+
+	bool is_defined( const string &name ) const;
+
+	// The symbols used without being defined.
+	vector<int> undefined( void ) const;
+
+	// The index as JSON:
+	//
+	//   {"productions":["name",...],
+	//    "symbols":{"name":{"defined":[prod,...],"used":[prod,...]},...},
+	//    "undefined":["name",...]}
+	void write_json( buffer &out ) const;
+
+private:
+	symbol_table _symbols;
+	vector<const production *> _prods;
+	vector<int> _defines;
+	vector<vector<int>> _uses;
+	vector<vector<int>> _defined_at;
+	vector<vector<int>> _used_at;
+};